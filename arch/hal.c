@@ -6,6 +6,7 @@
  */
 
 #include "hal.h"
+#include "sched.h"
 
 /*-----------------------------------------------------------*/
 
@@ -51,10 +52,15 @@ inline bool arch_interrupts_enabled(void) {
 /**
  * @brief Arch-specific task exit handler. Captures important state parameters, then transfers control to the scheduler.
  */
-static void __attribute__((naked, noreturn)) arch_task_exit(int exit_code) {
+void __attribute__((naked, noreturn)) arch_task_exit(int exit_code) {
 	arch_disable_interrupts();
-////	sched_task_exit();
-//	arch_restore_context();
+
+	/* the runnable's return value is still in R12, which is also the first argument register */
+	#ifdef __MSP430X_LARGE__
+		__asm__ __volatile__("calla #sched_task_exit");
+	#else
+		__asm__ __volatile__("call #sched_task_exit");
+	#endif
 
 	while (1) {
 		panic(PANIC_UNDEFINED, "arch_task_exit() failed");
@@ -114,8 +120,8 @@ volatile arch_reg_t *arch_init_stack(volatile arch_reg_t *stack_top,
 	stack_top--;
 	*stack_top = (arch_reg_t) arch_task_exit;
 
-	/* allocate an interrupt frame for context switching */
-	stack_top = (arch_reg_t *) (stack_base - sizeof(arch_iframe_t));
+	/* allocate an interrupt frame for context switching below it, the runnable returns into the exit handler */
+	stack_top = (arch_reg_t *) (stack_base - sizeof(arch_reg_t) - sizeof(arch_iframe_t));
 	arch_create_irq_frame((arch_iframe_t *) stack_top, xcode, GIE);
 
 	/**
@@ -187,10 +193,12 @@ volatile arch_reg_t *arch_init_stack(volatile arch_reg_t *stack_top,
 #if (CONFIG_USE_FAST_MATH == 1)
 	#define ARCH_1MS									((ARCH_TICK_CLK_FREQ) >> 10)
 	#define ARCH_MS_TO_CYCLES(ms)						((((uint32_t) ARCH_TICK_CLK_FREQ) * ((uint32_t) ms)) >> 10)
+	#define ARCH_CYCLES_TO_MS(cycles)					(((((uint32_t) cycles) << 10) + ARCH_TICK_CLK_FREQ - 1) / ARCH_TICK_CLK_FREQ)
 #else
 	#define ROUND(x) 									((x) >= 0 ? (long) ((x) + 0.5) : (long) ((x) - 0.5))
 	#define ARCH_1MS									(double) (ARCH_TICK_CLK_FREQ / 1000.0)
 	#define ARCH_MS_TO_CYCLES(ms)						ROUND(((double) ms) * ARCH_1MS)
+	#define ARCH_CYCLES_TO_MS(cycles)					((((uint32_t) cycles) * 1000 + ARCH_TICK_CLK_FREQ - 1) / ARCH_TICK_CLK_FREQ)
 #endif
 
 /**
@@ -201,11 +209,13 @@ static void arch_setup_timer_interrupt(unsigned int period) {
 	TA0CTL = MC_0 | TACLR;
 	TA0CCR0 = period;
 	TA0CCTL0 = CCIE;
+	TA0CCTL2 = CAP | CM_0 | CCIE;		/* capture mode with capturing off, so only arch_pend_plan() sets CCIFG */
 	TA0CTL = TASSEL_1 | ID_3 | MC_2;
 }
 
 static void arch_disable_timer_interrupt(void) {
 	TA0CTL = MC_0 | TACLR;
+	TA0CCTL2 = 0;
 }
 
 /**
@@ -222,6 +232,13 @@ static void arch_acknowledge_tick_interrupt() {
 	TA0CCR0 &= ~CCIFG;
 }
 
+/**
+ * @brief CCR2 never captures, so setting its flag is a software interrupt on the lower priority timer vector.
+ */
+void arch_pend_plan(void) {
+	TA0CCTL2 |= CCIFG;
+}
+
 /**
  * @brief Sets up an interrupt at the specified time.
  * @param[in] next_wake_time When to expect a thread awakening, measured in cycles.
@@ -270,6 +287,14 @@ unsigned int arch_time_now(void) {
 	return TA0R;
 }
 
+unsigned int arch_ms_to_cycles(unsigned int ms) {
+	return ARCH_MS_TO_CYCLES(ms);
+}
+
+unsigned int arch_cycles_to_ms(unsigned int cycles) {
+	return ARCH_CYCLES_TO_MS(cycles);
+}
+
 void arch_idle(void) {
 	_low_power_mode_3();
 }
@@ -283,6 +308,13 @@ void arch_idle(void) {
  * @{
  */
 
+/* Bytes of the boot stack taken by the kernel stack, directly under the saved boot context. */
+#if (CONFIG_ISR_USE_BOOT_STACK == 1)
+	#define ARCH_BOOT_ISR_STACK_SIZE					CONFIG_ISR_STACK_SIZE
+#else
+	#define ARCH_BOOT_ISR_STACK_SIZE					0
+#endif
+
 /**
  * @brief Boots up the scheduler and saves pre-boot state for quitting.
  */
@@ -297,6 +329,22 @@ void __attribute__((noinline)) arch_sched_start(void) {
 		__asm__ __volatile__("mov.w sp, %0" : "=r"(sched_p.boot_context));
 	#endif
 
+	/**
+	 * Everything below the saved boot context is free until arch_sched_end() reloads it,
+	 * so the kernel stack and then the idle stack can be carved out of it, top down.
+	 */
+	#if (CONFIG_ISR_USE_BOOT_STACK == 1)
+		sched_p.sched_isr_stack_top = sched_p.boot_context;
+	#endif
+
+	#if (CONFIG_IDLE_USE_BOOT_STACK == 1)
+
+		/* Step off the boot stack before the idle stack is painted and its context is built. */
+		arch_enter_kernel_stack();
+		sched_impl_idle_init((uint8_t *) sched_p.boot_context - ARCH_BOOT_ISR_STACK_SIZE - CONFIG_IDLE_STACK_SIZE,
+							CONFIG_IDLE_STACK_SIZE);
+	#endif
+
 	/* Set up the time slicing and safety hardware. */
 	arch_setup_timer_interrupt(ARCH_MS_TO_CYCLES(CONFIG_TICK_RATE_MS));
 	#if (CONFIG_WATCHDOG_MONITOR == 1)
@@ -326,6 +374,8 @@ void __attribute__((naked)) arch_sched_end(void) {
 	arch_restore_regs();
 
 	/**
+	 * The idle and kernel stacks may have been carved out below boot_context, but nothing at or above it
+	 * was touched, so the saved registers and return address are still intact.
 	 * After restoring registers, the noinline'd arch_sched_start() should have definitely
 	 * placed a return address on the stack that we can directly return into.
 	 */
@@ -436,31 +486,129 @@ static inline void __attribute__((always_inline)) arch_build_trapframe(void) {
 }
 
 /**
- * @brief Changes to any other runnable thread.
+ * Switch paths only stack what the scheduler call itself could clobber before asking it for a decision.
+ * If it keeps the running thread, they return straight into it. Otherwise, the rest of the context is
+ * pushed under what was already parked on the outgoing thread's stack, and the incoming one is restored.
+ * Switch paths never nest, so the outgoing thread can be remembered in a single variable.
  */
-void __attribute__((noinline, naked)) arch_yield(void) {
+static volatile thread_impl_t *arch_switch_from;
 
-	/* Manual context stacking. */
-	arch_context_switch_prologue();
-	arch_build_trapframe();
+/**
+ * Until r4 - r10 are pushed, they belong to the interrupted thread, so everything from the park to that push
+ * is one asm statement built from the fragments below. Its operands are all link-time constants, so the compiler
+ * has no register to allocate and nothing to emit inside it. The fragments only use r12, which is already
+ * stacked or given up by the time a switch path parks.
+ */
+#ifdef __MSP430X_LARGE__
+	#define ARCH_ASM_MOV					"mov.a"
+	#define ARCH_ASM_CALL					"calla"
+	#define ARCH_ASM_TCB_FRAME				"4"
+#else
+	#define ARCH_ASM_MOV					"mov.w"
+	#define ARCH_ASM_CALL					"call"
+	#define ARCH_ASM_TCB_FRAME				"2"
+#endif
 
-	/* Standard context switching logic. */
-	arch_save_context();
+#define ARCH_ASM_TCB_SP						"0"
 
-	/* Check for stack overflow. */
-	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+_Static_assert(offsetof(thread_impl_t, sp) == 0, "switch paths address thread_impl_t.sp as ARCH_ASM_TCB_SP");
+_Static_assert(offsetof(thread_impl_t, frame) == sizeof(void *), "switch paths address thread_impl_t.frame as ARCH_ASM_TCB_FRAME");
 
-	#endif
+/* Same as arch_enter_kernel_stack(), as text. */
+#if (CONFIG_USE_KERNEL_STACK == 1) && (CONFIG_ISR_USE_BOOT_STACK == 1)
+	#define ARCH_ASM_ENTER_KERNEL_STACK		ARCH_ASM_MOV " %[kstack], sp\n\t"
+	#define ARCH_ASM_KERNEL_STACK_TOP		"m"(sched_p.sched_isr_stack_top)
+#elif (CONFIG_USE_KERNEL_STACK == 1)
+	#define ARCH_ASM_ENTER_KERNEL_STACK		ARCH_ASM_MOV " %[kstack], sp\n\t"
+	#define ARCH_ASM_KERNEL_STACK_TOP		"i"(sched_p.sched_isr_stack + CONFIG_ISR_STACK_SIZE)
+#else
+	#define ARCH_ASM_ENTER_KERNEL_STACK		""
+	#define ARCH_ASM_KERNEL_STACK_TOP		"i"(0)
+#endif
+
+/* Records the stack pointer of the running thread, over whatever part of its context is already stacked. */
+#define ARCH_ASM_PARK																\
+	ARCH_ASM_MOV " %[active], r12\n\t"												\
+	ARCH_ASM_MOV " sp, " ARCH_ASM_TCB_SP "(r12)\n\t"								\
+	ARCH_ASM_ENTER_KERNEL_STACK
+
+/* Goes back to the parked stack of the running thread. */
+#define ARCH_ASM_UNPARK																\
+	ARCH_ASM_MOV " %[active], r12\n\t"												\
+	ARCH_ASM_MOV " " ARCH_ASM_TCB_SP "(r12), sp\n\t"
+
+/* Calls arch_switch_decide(decide), leaving Z set if the running thread stays. */
+#define ARCH_ASM_DECIDE																\
+	ARCH_ASM_MOV " %[decide], r12\n\t"												\
+	ARCH_ASM_CALL " %[fn]\n\t"														\
+	"tst.b r12\n\t"
+
+/* Pushes r4 - r10 under the parked context of the outgoing thread, records the frame format, and leaves its stack. */
+#define ARCH_ASM_FINISH_SWITCH_FROM													\
+	ARCH_ASM_MOV " %[from], r12\n\t"												\
+	ARCH_ASM_MOV " " ARCH_ASM_TCB_SP "(r12), sp\n\t"								\
+	ARCH_ASM_SAVE_CALLEE_REGS														\
+	ARCH_ASM_MOV " sp, " ARCH_ASM_TCB_SP "(r12)\n\t"								\
+	"mov.w %[frame], " ARCH_ASM_TCB_FRAME "(r12)\n\t"								\
+	ARCH_ASM_ENTER_KERNEL_STACK
+
+/* Returns into the running thread after an interrupt, out of low power mode in case a woken thread needs the idle thread to notice. */
+#define ARCH_ASM_RESUME_FULL														\
+	ARCH_ASM_UNPARK																	\
+	ARCH_ASM_RESTORE_SCRATCH_REGS													\
+	"bic %[lpm], 0(sp)\n\t"															\
+	"reti\n\t"
+
+/* Returns into the running thread after a yield. */
+#define ARCH_ASM_RESUME_VOLUNTARY													\
+	ARCH_ASM_UNPARK																	\
+	"reti\n\t"
+
+#define ARCH_ASM_SWITCH_OPERANDS(_decide, _frame)									\
+	[active] "m"(sched_p.sched_active_thread), [from] "m"(arch_switch_from),		\
+	[kstack] ARCH_ASM_KERNEL_STACK_TOP, [fn] "i"(arch_switch_decide),				\
+	[decide] "i"(_decide), [frame] "i"(_frame), [lpm] "i"(CPUOFF | OSCOFF | SCG0 | SCG1)
+
+#define ARCH_ASM_SWITCH_CLOBBERS	"r11", "r12", "r13", "r14", "r15", "memory"
+
+/**
+ * @brief Runs a scheduler decision and reports whether it picked a different thread.
+ * @details An ordinary function, so r4 - r10 survive it as the switch paths rely on.
+ */
+static bool __attribute__((noinline)) arch_switch_decide(void (*decide)(void)) {
+	arch_switch_from = sched_p.sched_active_thread;
 
-	/* Find a new thread of any priority. */
-	sched_impl_yield();
+	decide();
 
-	/* Check if the newly scheduled thread holds a critical section, and restore the lock if true. */
+	if (sched_p.sched_active_thread == arch_switch_from) {
+		sched_p.switches_skipped++;
+		return false;
+	}
+
+	sched_p.switches++;
+	return true;
+}
+
+/**
+ * @brief Checks the outgoing thread for stack overflow, now that its whole context is on its stack.
+ * @details Runs on the kernel stack, so the check can't run over the outgoing thread's canary.
+ */
+static inline void __attribute__((always_inline)) arch_check_switch_from(void) {
+	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+		thread_impl_check_stack((thread_impl_t *) arch_switch_from);
+	#endif
+}
+
+/**
+ * @brief Restores the critical section of an incoming thread that yielded while holding one.
+ */
+static inline void __attribute__((always_inline)) arch_relock_switch_to(void) {
 	if (sched_p.state & SCHED_STATUS_IRQ_LOCKED) {
 
 		/* We need to modify the stack, so we need to get the location of the interrupt status register. */
 		const register volatile uint8_t *stack_top = (uint8_t *) sched_p.sched_active_thread->sp;
-		const register unsigned int iframe_offs = offsetof(arch_context_t, task_addr);
+		const register unsigned int iframe_offs = (sched_p.sched_active_thread->frame == ARCH_FRAME_VOLUNTARY) ?
+			offsetof(arch_voluntary_context_t, task_addr) : offsetof(arch_context_t, task_addr);
 		register volatile uint8_t *arch_iframe_pos = (uint8_t *) (stack_top + iframe_offs);
 
 		/**
@@ -469,48 +617,73 @@ void __attribute__((noinline, naked)) arch_yield(void) {
 		 */
 		*arch_iframe_pos &= ~ARCH_FLAG_INTERRUPTS_ENABLED;
 	}
-
-	/* Return into the thread. */
-	arch_restore_context();
 }
 
 /**
- * @brief Changes to a higher priority thread.
+ * @brief Body shared by the voluntary switch paths, inlined into each naked entry point.
+ * @param[in] decide Scheduler call that picks the next thread. Must be a constant, it becomes an immediate of the switch asm.
  */
-void __attribute__((noinline, naked)) arch_yield_higher(void) {
+static inline void __attribute__((always_inline)) arch_voluntary_switch(void (*decide)(void)) {
 
 	/* Manual context stacking. */
 	arch_context_switch_prologue();
 	arch_build_trapframe();
 
-	/* Standard context switching logic. */
-	arch_save_context();
-
-	/* Check for stack overflow. */
-	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+	/**
+	 * The caller already gave up r11 - r15, so nothing but the trapframe is needed to decide.
+	 * The scheduler runs on the kernel stack so thread stacks only need room for their saved context.
+	 * Only finish saving the context if the decision isn't this thread, otherwise return into it.
+	 */
+	__asm__ __volatile__(
+		ARCH_ASM_PARK
+		ARCH_ASM_DECIDE
+		"jnz 1f\n\t"
+		ARCH_ASM_RESUME_VOLUNTARY
+		"1:\n\t"
+		ARCH_ASM_FINISH_SWITCH_FROM
+		: : ARCH_ASM_SWITCH_OPERANDS(decide, ARCH_FRAME_VOLUNTARY) : ARCH_ASM_SWITCH_CLOBBERS);
+
+	arch_check_switch_from();
+	arch_relock_switch_to();
+	arch_restore_context();
+}
 
-	#endif
+/**
+ * @brief Changes to any other runnable thread.
+ */
+void __attribute__((noinline, naked)) arch_yield(void) {
+	arch_voluntary_switch(sched_impl_yield);
+}
 
-	/* Find a higher priority thread and return into it if possible. */
-	sched_impl_yield_higher();
+/**
+ * @brief Changes to a higher priority thread.
+ */
+void __attribute__((noinline, naked)) arch_yield_higher(void) {
+	arch_voluntary_switch(sched_impl_yield_higher);
+}
 
-	/* Check if the newly scheduled thread holds a critical section, and restore the lock if true. */
-	if (sched_p.state & SCHED_STATUS_IRQ_LOCKED) {
+/**
+ * @brief Recipient of the handoff in progress. Switch paths never nest, so one is enough.
+ */
+static thread_impl_t *arch_switch_target;
 
-		/* We need to modify the stack, so we need to get the location of the interrupt status register. */
-		const register volatile uint8_t *stack_top = (uint8_t *) sched_p.sched_active_thread->sp;
-		const register unsigned int iframe_offs = offsetof(arch_context_t, task_addr);
-		register volatile uint8_t *arch_iframe_pos = (uint8_t *) (stack_top + iframe_offs);
+/**
+ * @brief The decision is already made, only the backend's accounting is left.
+ */
+static void arch_switch_to_target(void) {
+	sched_impl_switch_to(arch_switch_target);
+}
 
-		/**
-		 * Disabling interrupts will allow the new thread to proceed uninterrupted
-		 * since it must have yielded in a critical section.
-		 */
-		*arch_iframe_pos &= ~ARCH_FLAG_INTERRUPTS_ENABLED;
-	}
+/**
+ * @brief Changes to arch_switch_target.
+ */
+static void __attribute__((noinline, naked)) arch_yield_to_target(void) {
+	arch_voluntary_switch(arch_switch_to_target);
+}
 
-	/* Return into the thread. */
-	arch_restore_context();
+void arch_switch_to(thread_impl_t *target) {
+	arch_switch_target = target;
+	arch_yield_to_target();
 }
 
 /**
@@ -536,23 +709,53 @@ void arch_sleep_for(unsigned int ms) {
 	arch_sleep_until(wake_time);
 }
 
+/**
+ * @brief Blocks the current thread on a kernel object until it is woken or the timeout expires.
+ * @param[in] que Wait queue of the kernel object.
+ * @param[in] status What the thread is blocked on.
+ * @param[in] ms How long to wait, in milliseconds. 0 fails immediately, SCHED_WAIT_FOREVER never times out.
+ * @return wake_reason_t describing why the thread is running again.
+ */
+unsigned int arch_wait_for(wait_queue_t *que, unsigned int status, unsigned int ms) {
+	thread_impl_t *me = (thread_impl_t *) sched_p.sched_active_thread;
+
+	me->wq_entry.que = que;
+	me->wq_entry.arg = 0;
+	return arch_wait_set_for(&me->wq_entry, 1, status, ms);
+}
 
 /**
- * @brief Scheduler preemption tick. Invokes sched_run() to distribute time slices.
+ * @brief Blocks the current thread on several kernel objects until one fires or the timeout expires.
+ * @param[in] set Wait records with 'que' and 'arg' filled in.
+ * @param[in] len Number of records.
+ * @param[in] status What the thread is blocked on.
+ * @param[in] ms How long to wait, in milliseconds. 0 fails immediately, SCHED_WAIT_FOREVER never times out.
+ * @return wake_reason_t describing why the thread is running again.
  */
-__attribute__((naked, interrupt(ARCH_TICK_VECTOR))) void arch_tick_irq(void) {
+unsigned int arch_wait_set_for(wait_queue_entry_t *set, unsigned int len, unsigned int status, unsigned int ms) {
+	if (ms == 0) return WAKE_TIMEOUT;
 
-	/* Standard context switching logic. */
-	arch_save_context();
+	if (ms == SCHED_WAIT_FOREVER) {
+		sched_impl_wait_set(set, len, status);
+		arch_yield();
+	} else {
+		unsigned int wake_time = arch_time_now() + ARCH_MS_TO_CYCLES(ms);
 
-	arch_acknowledge_tick_interrupt();
+		sched_impl_wait_set_until(set, len, status, wake_time);
+		arch_sleep_until(wake_time);
+	}
 
-	profile_start();
+	return sched_p.sched_active_thread->wake_reason;
+}
 
-	/* Check for stack overflow. */
-	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
 
-	#endif
+/**
+ * @brief Tick work done between parking and resuming a thread. Picks the next thread and rearms the tick.
+ */
+static void arch_tick(void) {
+	arch_acknowledge_tick_interrupt();
+
+	profile_start();
 
 	/* Find the next logical thread in the sequence. */
 	sched_impl_run();
@@ -576,44 +779,52 @@ __attribute__((naked, interrupt(ARCH_TICK_VECTOR))) void arch_tick_irq(void) {
 	#endif
 
 	profile_end();
-	arch_restore_context();
 }
 
-__attribute__((naked, interrupt(ARCH_TIMEKEEPING_VECTOR))) void arch_time_irq(void) {
-	arch_enter_isr();
+/**
+ * @brief Scheduler preemption tick. Invokes sched_run() to distribute time slices.
+ */
+__attribute__((naked, interrupt(ARCH_TICK_VECTOR))) void arch_tick_irq(void) {
 
-	switch (__even_in_range(TA0IV, TA0IV_TAIFG)) {
+	/* The interrupted thread needs r11 - r15 back no matter what, r4 - r10 only if it is switched away from. */
+	arch_save_scratch_regs();
 
-		/* We shouldn't be able to trap into an interrupt without the hardware knowing. */
-		case TA0IV_NONE:
-			panic(PANIC_EXPECT_FAIL, "Unexpected trap into ARCH_TIMEKEEPING_VECTOR");
-			break;
+	__asm__ __volatile__(
+		ARCH_ASM_PARK
+		ARCH_ASM_DECIDE
+		"jnz 1f\n\t"
+		ARCH_ASM_RESUME_FULL
+		"1:\n\t"
+		ARCH_ASM_FINISH_SWITCH_FROM
+		: : ARCH_ASM_SWITCH_OPERANDS(arch_tick, ARCH_FRAME_FULL) : ARCH_ASM_SWITCH_CLOBBERS);
+
+	arch_check_switch_from();
+	arch_restore_context();
+}
+
+/**
+ * @brief Reads and handles the pending timekeeping event. Reading TA0IV clears it, so this is done exactly once.
+ * @details A pended plan is an ordinary call that never switches threads, so it is finished here.
+ * @return True for a wakeup, which may have to switch to a woken thread.
+ */
+static bool __attribute__((noinline)) arch_time_event(void) {
+	switch (__even_in_range(TA0IV, TA0IV_TAIFG)) {
 
 		/* Whenever a wakeup happens. */
 		case TA0IV_TACCR1:
+			return true;
 
-			/* Necessary so we don't get in a loop here. */
-			arch_acknowledge_wakeup_interrupt();
-
-			/* First get the thread that needs to be awoken right now and add it back to the run queue. */
-			volatile thread_impl_t *waker = sleep_queue_peek(&sched_p.sleep_mgr);
-			sleep_queue_pop(&sched_p.sleep_mgr);
-			sched_impl_register(waker);
-
-			/**
-			 * Next find out who's next on the list, and if there is no one on the list, turn off the
-			 * wakeup interrupt. Otherwise, configure the wakeup interrupt for the entry's stated wakeup time.
-			 */
-			volatile thread_impl_t *next_waker = sleep_queue_peek(&sched_p.sleep_mgr);
-			if (next_waker == 0) arch_suppress_wakeup_interrupt();
-			else arch_schedule_next_wakeup(next_waker->sq_entry.wake_time);
-			break;
-
-		/* Unused for now, so these are all unexpected traps. */
+		/* Pended whenever the planned decision goes stale, see arch_pend_plan(). */
 		case TA0IV_TACCR2:
+			sched_impl_plan();
+			return false;
+
+		/* We shouldn't be able to trap into an interrupt without the hardware knowing. */
+		case TA0IV_NONE:
 			panic(PANIC_EXPECT_FAIL, "Unexpected trap into ARCH_TIMEKEEPING_VECTOR");
 			break;
 
+		/* Unused for now, so these are all unexpected traps. */
 		case TA0IV_TACCR3:
 			panic(PANIC_EXPECT_FAIL, "Unexpected trap into ARCH_TIMEKEEPING_VECTOR");
 			break;
@@ -638,7 +849,68 @@ __attribute__((naked, interrupt(ARCH_TIMEKEEPING_VECTOR))) void arch_time_irq(vo
 			break;
 	}
 
-	arch_exit_isr();
+	return false;
+}
+
+/**
+ * @brief Wakeup work done between parking and resuming a thread. Yields to a woken thread if it outranks the running one.
+ */
+static void arch_time_wakeup(void) {
+
+	/* Woken threads only request a switch while we're marked as in an IRQ. */
+	sched_p.state |= SCHED_STATUS_IN_IRQ;
+
+	/* Necessary so we don't get in a loop here. */
+	arch_acknowledge_wakeup_interrupt();
+
+	/**
+	 * First put every thread that is due back on the run queue, pulling any that timed out
+	 * off the wait queue they were blocked on.
+	 */
+	volatile thread_impl_t *next_waker = sched_impl_wake_expired(arch_time_now());
+
+	/**
+	 * Next, if there is no one left on the list, turn off the wakeup interrupt.
+	 * Otherwise, configure the wakeup interrupt for the entry's stated wakeup time.
+	 */
+	if (next_waker == 0) arch_suppress_wakeup_interrupt();
+	else arch_schedule_next_wakeup(next_waker->sq_entry.wake_time);
+
+	sched_p.state &= ~SCHED_STATUS_IN_IRQ;
+
+	/* if the interrupt awakened a high priority thread, select that for context switch */
+	if (sched_p.state & SCHED_STATUS_CONTEXT_SWITCH_REQUEST) {
+		sched_p.state &= ~SCHED_STATUS_CONTEXT_SWITCH_REQUEST;
+		sched_impl_yield_higher();
+	}
+}
+
+/**
+ * @brief Wakeups and scheduler planning. Saved like the tick, so a plan costs r11 - r15 and never a full context.
+ */
+__attribute__((naked, interrupt(ARCH_TIMEKEEPING_VECTOR))) void arch_time_irq(void) {
+	arch_save_scratch_regs();
+
+	/* A plan leaves the running thread, and whatever power mode it was in, alone. */
+	__asm__ __volatile__(
+		ARCH_ASM_PARK
+		ARCH_ASM_CALL " %[event]\n\t"
+		"tst.b r12\n\t"
+		"jnz 1f\n\t"
+		ARCH_ASM_UNPARK
+		ARCH_ASM_RESTORE_SCRATCH_REGS
+		"reti\n\t"
+		"1:\n\t"
+		ARCH_ASM_DECIDE
+		"jnz 2f\n\t"
+		ARCH_ASM_RESUME_FULL
+		"2:\n\t"
+		ARCH_ASM_FINISH_SWITCH_FROM
+		: : ARCH_ASM_SWITCH_OPERANDS(arch_time_wakeup, ARCH_FRAME_FULL), [event] "i"(arch_time_event)
+		: ARCH_ASM_SWITCH_CLOBBERS);
+
+	arch_check_switch_from();
+	arch_restore_context();
 }
 
 /** @} */
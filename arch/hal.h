@@ -69,6 +69,30 @@ typedef struct arch_task_context {
 	arch_reg_t task_exit;		/* return address for task deletion */
 } arch_context_t;
 
+/**
+ * @brief The layout of thread context saved by a voluntary switch, as seen on the stack.
+ * @details Only the callee-saved registers sit above the trapframe. Threads enter a yield through
+ * an ordinary call, so r11 - r15 hold nothing their caller expects to survive it.
+ */
+typedef struct arch_voluntary_context {
+	arch_reg_t r4;				/* top of stack */
+	arch_reg_t r5;
+	arch_reg_t r6;
+	arch_reg_t r7;
+	arch_reg_t r8;
+	arch_reg_t r9;
+	arch_reg_t r10;
+	arch_iframe_t task_addr;	/* return address into the task */
+} arch_voluntary_context_t;
+
+/**
+ * @name Saved context frame formats, recorded per thread in thread_impl_t's frame.
+ * @{
+ */
+#define ARCH_FRAME_FULL									0	/* arch_context_t, from preemption or a new thread */
+#define ARCH_FRAME_VOLUNTARY							1	/* arch_voluntary_context_t, from a yield */
+/** @} */
+
 /**
  * @brief Underlying data type used for timekeeping.
  */
@@ -139,6 +163,88 @@ static inline __attribute__((always_inline)) void arch_restore_regs(void) {
 	#endif
 }
 
+/**
+ * @brief Instruction text pushing the callee-saved registers r4 - r10, for asm that must not be split up.
+ */
+#if defined(__MSP430_HAS_MSP430XV2_CPU__)  || defined(__MSP430_HAS_MSP430X_CPU__)
+	#ifdef __MSP430X_LARGE__
+		#define ARCH_ASM_SAVE_CALLEE_REGS	"pushm.a #7, r10\n\t"		/* pushes 10 -> 4 */
+	#else
+		#define ARCH_ASM_SAVE_CALLEE_REGS	"pushm.w #7, r10\n\t"
+	#endif
+#else
+	#define ARCH_ASM_SAVE_CALLEE_REGS		"push.w r10\n\tpush.w r9\n\tpush.w r8\n\tpush.w r7\n\t"	\
+											"push.w r6\n\tpush.w r5\n\tpush.w r4\n\t"
+#endif
+
+/**
+ * @brief Pushes the callee-saved registers r4 - r10. No bookkeeping data maintained.
+ */
+static inline __attribute__((always_inline)) void arch_save_callee_regs(void) {
+	__asm__ __volatile__(ARCH_ASM_SAVE_CALLEE_REGS);
+}
+
+/**
+ * @brief Pops the callee-saved registers r4 - r10. No bookkeeping data maintained.
+ */
+static inline __attribute__((always_inline)) void arch_restore_callee_regs(void) {
+	#if defined(__MSP430_HAS_MSP430XV2_CPU__)  || defined(__MSP430_HAS_MSP430X_CPU__)
+		#ifdef __MSP430X_LARGE__
+			__asm__ __volatile__("popm.a #7, r10");		/* pops 4 -> 10 */
+		#else
+			__asm__ __volatile__("popm.w #7, r10");
+		#endif
+	#else
+		__asm__ __volatile__("pop.w r4");
+		__asm__ __volatile__("pop.w r5");
+		__asm__ __volatile__("pop.w r6");
+		__asm__ __volatile__("pop.w r7");
+		__asm__ __volatile__("pop.w r8");
+		__asm__ __volatile__("pop.w r9");
+		__asm__ __volatile__("pop.w r10");
+	#endif
+}
+
+/**
+ * @brief Pushes the caller-saved registers r11 - r15. No bookkeeping data maintained.
+ * @details Together with a later arch_save_callee_regs(), this lays out the same frame as arch_save_regs().
+ */
+static inline __attribute__((always_inline)) void arch_save_scratch_regs(void) {
+	#if defined(__MSP430_HAS_MSP430XV2_CPU__)  || defined(__MSP430_HAS_MSP430X_CPU__)
+		#ifdef __MSP430X_LARGE__
+			__asm__ __volatile__("pushm.a #5, r15");	/* pushes 15 -> 11 */
+		#else
+			__asm__ __volatile__("pushm.w #5, r15");
+		#endif
+	#else
+		__asm__ __volatile__("push.w r15");
+		__asm__ __volatile__("push.w r14");
+		__asm__ __volatile__("push.w r13");
+		__asm__ __volatile__("push.w r12");
+		__asm__ __volatile__("push.w r11");
+	#endif
+}
+
+/**
+ * @brief Instruction text popping the caller-saved registers r11 - r15, for asm that must not be split up.
+ */
+#if defined(__MSP430_HAS_MSP430XV2_CPU__)  || defined(__MSP430_HAS_MSP430X_CPU__)
+	#ifdef __MSP430X_LARGE__
+		#define ARCH_ASM_RESTORE_SCRATCH_REGS	"popm.a #5, r15\n\t"		/* pops 11 -> 15 */
+	#else
+		#define ARCH_ASM_RESTORE_SCRATCH_REGS	"popm.w #5, r15\n\t"
+	#endif
+#else
+	#define ARCH_ASM_RESTORE_SCRATCH_REGS		"pop.w r11\n\tpop.w r12\n\tpop.w r13\n\tpop.w r14\n\tpop.w r15\n\t"
+#endif
+
+/**
+ * @brief Pops the caller-saved registers r11 - r15. No bookkeeping data maintained.
+ */
+static inline __attribute__((always_inline)) void arch_restore_scratch_regs(void) {
+	__asm__ __volatile__(ARCH_ASM_RESTORE_SCRATCH_REGS);
+}
+
 /**
  * @brief Saves system registers and then updates sched_active_thread for calls to arch_restore_context().
  */
@@ -169,43 +275,59 @@ static inline __attribute__((always_inline)) void arch_save_context(void) {
 
 		__asm__ __volatile__("mov.w sp, %0" : "=r"(sched_p.sched_active_thread->sp));
 	#endif
+
+	sched_p.sched_active_thread->frame = ARCH_FRAME_FULL;
+}
+
+/**
+ * @brief Moves SP to the top of the kernel stack. Only valid once the running thread's SP is stored in its TCB.
+ * @details The thread's SP is already parked in its TCB by then, and arch_restore_context() reloads it,
+ * so nothing on the kernel stack has to outlive a single ISR or context switch. Every entry starts from
+ * the top of the stack, so OS-aware ISRs must not re-enable interrupts and nest.
+ * Without CONFIG_USE_KERNEL_STACK, this is a no-op and the kernel runs on the interrupted thread's stack.
+ * With CONFIG_ISR_USE_BOOT_STACK, the top comes from sched_p.sched_isr_stack_top instead of a static buffer.
+ */
+static inline __attribute__((always_inline)) void arch_enter_kernel_stack(void) {
+	#if (CONFIG_USE_KERNEL_STACK == 1) && (CONFIG_ISR_USE_BOOT_STACK == 1)
+		#ifdef __MSP430X_LARGE__
+			__asm__ __volatile__("mov.a %0, sp" : : "m"(sched_p.sched_isr_stack_top));
+		#else
+			__asm__ __volatile__("mov.w %0, sp" : : "m"(sched_p.sched_isr_stack_top));
+		#endif
+	#elif (CONFIG_USE_KERNEL_STACK == 1)
+		#ifdef __MSP430X_LARGE__
+			__asm__ __volatile__("mov.a %0, sp" : : "i"(sched_p.sched_isr_stack + CONFIG_ISR_STACK_SIZE));
+		#else
+			__asm__ __volatile__("mov.w %0, sp" : : "i"(sched_p.sched_isr_stack + CONFIG_ISR_STACK_SIZE));
+		#endif
+	#endif
 }
 
 /**
  * @brief Grabs sched_active_thread's bookkeeping data and then pulls system registers off the stack.
+ * @details Pops as many registers as the saved context's frame format holds.
  */
 static inline __attribute__((always_inline)) void arch_restore_context(void) {
 
-	/* grabs sched_active_thread, pops registers r4 -> r15, then returns into the task */
-	#if defined(__MSP430_HAS_MSP430XV2_CPU__)  || defined(__MSP430_HAS_MSP430X_CPU__)
+	/* grabs sched_active_thread, pops registers r4 -> r10 or r4 -> r15, then returns into the task */
+	if (sched_p.sched_active_thread->frame == ARCH_FRAME_VOLUNTARY) {
 		#ifdef __MSP430X_LARGE__
-				__asm__ __volatile__("mov.a %0, sp" : : "m"(sched_p.sched_active_thread->sp));
-				__asm__ __volatile__("popm.a #12, r15");	// pops 4 -> 15
+			__asm__ __volatile__("mov.a %0, sp" : : "m"(sched_p.sched_active_thread->sp));
 		#else
-				__asm__ __volatile__("mov.w %0, sp" : : "m"(sched_p.sched_active_thread->sp));
-				__asm__ __volatile__("popm.w #12, r15");
+			__asm__ __volatile__("mov.w %0, sp" : : "m"(sched_p.sched_active_thread->sp));
 		#endif
+		arch_restore_callee_regs();
+	} else {
+		#ifdef __MSP430X_LARGE__
+			__asm__ __volatile__("mov.a %0, sp" : : "m"(sched_p.sched_active_thread->sp));
+		#else
+			__asm__ __volatile__("mov.w %0, sp" : : "m"(sched_p.sched_active_thread->sp));
+		#endif
+		arch_restore_regs();
+	}
 
-		__asm__ __volatile__("bic %0, 0(sp)" : : "i"(CPUOFF | OSCOFF | SCG0 | SCG1));
-		__asm__ __volatile__("reti");
-	#else
-		__asm__ __volatile__("mov.w %0, sp" : : "m"(sched_p.sched_active_thread->sp));
-		__asm__ __volatile__("pop.w r4");
-		__asm__ __volatile__("pop.w r5");
-		__asm__ __volatile__("pop.w r6");
-		__asm__ __volatile__("pop.w r7");
-		__asm__ __volatile__("pop.w r8");
-		__asm__ __volatile__("pop.w r9");
-		__asm__ __volatile__("pop.w r10");
-		__asm__ __volatile__("pop.w r11");
-		__asm__ __volatile__("pop.w r12");
-		__asm__ __volatile__("pop.w r13");
-		__asm__ __volatile__("pop.w r14");
-		__asm__ __volatile__("pop.w r15");
-
-		__asm__ __volatile__("bic %0, 0(sp)" : : "i"(CPUOFF | OSCOFF | SCG0 | SCG1));
-		__asm__ __volatile__("reti");
-	#endif
+	__asm__ __volatile__("bic %0, 0(sp)" : : "i"(CPUOFF | OSCOFF | SCG0 | SCG1));
+	__asm__ __volatile__("reti");
 }
 
 /** @} */
@@ -233,13 +355,7 @@ static inline void __attribute__((always_inline)) arch_enter_isr(void) {
 	arch_save_context();
 
 	/* changing to a separate kernel interrupt stack reduces stack overflow potential */
-	#if (CONFIG_USE_KERNEL_STACK == 1)
-		#ifdef __MSP430X_LARGE__
-				__asm__ __volatile__("mov.a %0, sp" : : "i"(sched_p.sched_isr_stack + CONFIG_ISR_STACK_SIZE));
-		#else
-				__asm__ __volatile__("mov.w %0, sp" : : "i"(sched_p.sched_isr_stack + CONFIG_ISR_STACK_SIZE));
-		#endif
-	#endif
+	arch_enter_kernel_stack();
 
 	/* notify that we're in an IRQ */
 	sched_p.state |= SCHED_STATUS_IN_IRQ;
@@ -256,6 +372,7 @@ static inline void __attribute__((always_inline)) arch_exit_isr(void) {
 	/* if the interrupt awakened a high priority thread, select that for context switch */
 
 	if (sched_p.state & SCHED_STATUS_CONTEXT_SWITCH_REQUEST) {
+		sched_p.state &= ~SCHED_STATUS_CONTEXT_SWITCH_REQUEST;
 		sched_impl_yield_higher();
 	}
 
@@ -324,6 +441,31 @@ volatile arch_reg_t *arch_init_stack(volatile arch_reg_t *stack_top,
 									volatile thread_fn_t xcode,
 									volatile void *fn_args);
 
+/**
+ * @brief Return address planted under every thread runnable. Retires the thread through sched_task_exit().
+ */
+void __attribute__((naked, noreturn)) arch_task_exit(int exit_code);
+
+/**
+ * @def ARCH_CONTEXT_INIT
+ * @brief Constant initializer for the context arch_init_stack() would build, so it can be prebuilt at compile time.
+ * @details Only available when the trapframe is a plain copy of the PC. 20-bit MSP430s split the PC
+ * around the SR, which isn't a link-time constant, so ARCH_HAS_CONTEXT_INIT is 0 there.
+ */
+#ifdef __MSP430X_LARGE__
+	#define ARCH_HAS_CONTEXT_INIT				0
+#else
+	#define ARCH_HAS_CONTEXT_INIT				1
+
+	#define ARCH_CONTEXT_INIT(xcode, fn_args) {																\
+		.r4 = 0x4444, .r5 = 0x5555, .r6 = 0x6666, .r7 = 0x7777,											\
+		.r8 = 0x8888, .r9 = 0x9999, .r10 = 0xaaaa, .r11 = 0xbbbb,										\
+		.r12 = (arch_reg_t) (fn_args), .r13 = 0xcccc, .r14 = 0xdddd, .r15 = 0xeeee,						\
+		.task_addr = { .words = { GIE, (uint16_t) (xcode) } },											\
+		.task_exit = (arch_reg_t) arch_task_exit														\
+	}
+#endif
+
 /**
  * @brief Starts the OS scheduler. Invokes arch_setup_timer_interrupt().
  */
@@ -351,6 +493,52 @@ void __attribute__((noinline, naked)) arch_yield(void);
  */
 void __attribute__((noinline, naked)) arch_yield_higher(void);
 
+/**
+ * @brief Manual context switch. Hands the rest of the time slice to the given runnable thread. Call with irq_lock() held.
+ * @param[in] target Thread to run next, on the run queue and not the running thread.
+ */
+void arch_switch_to(thread_impl_t *target);
+
+/**
+ * @brief Pends a low priority interrupt that calls sched_impl_plan(), so the next tick only has to commit the plan.
+ */
+void arch_pend_plan(void);
+
+/**
+ * @brief Blocks the current thread on a kernel object wait queue, with an optional timeout. Call with irq_lock() held.
+ * @param[in] que Wait queue of the kernel object.
+ * @param[in] status thread_status_t describing what the thread is blocked on.
+ * @param[in] ms Timeout in milliseconds. 0 fails immediately, SCHED_WAIT_FOREVER never times out.
+ * @return wake_reason_t describing why the thread is running again.
+ */
+unsigned int arch_wait_for(wait_queue_t *que, unsigned int status, unsigned int ms);
+
+/**
+ * @brief Blocks the current thread on several kernel objects at once, with an optional timeout. Call with irq_lock() held.
+ * @param[in] set Wait records with 'que' and 'arg' filled in. The index of the record that fired is left in wake_index.
+ * @param[in] len Number of records.
+ * @param[in] status thread_status_t describing what the thread is blocked on.
+ * @param[in] ms Timeout in milliseconds. 0 fails immediately, SCHED_WAIT_FOREVER never times out.
+ * @return wake_reason_t describing why the thread is running again.
+ */
+unsigned int arch_wait_set_for(wait_queue_entry_t *set, unsigned int len, unsigned int status, unsigned int ms);
+
+/**
+ * @brief Reads the free-running timekeeping timer.
+ * @return Current time in timer cycles. Wraps, so only differences are meaningful.
+ */
+unsigned int arch_time_now(void);
+
+/**
+ * @brief Converts a duration in milliseconds to timekeeping timer cycles.
+ */
+unsigned int arch_ms_to_cycles(unsigned int ms);
+
+/**
+ * @brief Converts a duration in timekeeping timer cycles to milliseconds, rounding up so waits never end early.
+ */
+unsigned int arch_cycles_to_ms(unsigned int cycles);
+
 /** @} */
 
 #ifdef __cplusplus
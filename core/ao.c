@@ -0,0 +1,139 @@
+/*
+ * ao.c
+ *
+ *  Created on: Jul 23, 2020
+ *      Author: krad2
+ */
+
+#include <limits.h>
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "ao.h"
+
+_Static_assert(CONFIG_AO_PRIORITIES < sizeof(unsigned int) * CHAR_BIT, "CONFIG_AO_PRIORITIES must leave the top ready bit free");
+
+/**
+ * @brief Highest priority in a nonempty ready set.
+ */
+static inline unsigned int ao_highest(unsigned int ready) {
+	return (sizeof(unsigned int) * CHAR_BIT) - 1 - __builtin_clz(ready);
+}
+
+void ao_kernel_init(ao_kernel_t *k) {
+	for (unsigned int i = 0; i < CONFIG_AO_PRIORITIES; ++i) {
+		k->aos[i] = NULL;
+	}
+
+	k->ready = 0;
+	k->ceiling = 0;
+	k->host = NULL;
+}
+
+void ao_init(ao_t *ao, ao_handler_t handler, unsigned int priority, const ao_event_t **storage, unsigned int len) {
+	if (len == 0 || (len & (len - 1)) != 0) panic(PANIC_ASSERT_FAIL, "Active object queue length must be a power of two");
+
+	ao->handler = handler;
+	ao->kernel = NULL;
+	ao->priority = priority;
+	ringbuf_init(&ao->queue, (void *) storage, sizeof(const ao_event_t *), len);
+	ao->dispatched = 0;
+	ao->dropped = 0;
+}
+
+void ao_start(ao_kernel_t *k, ao_t *ao) {
+	if (ao->priority >= CONFIG_AO_PRIORITIES) panic(PANIC_ASSERT_FAIL, "Active object priority out of range");
+
+	irq_lock();
+
+	if (k->aos[ao->priority] != NULL) panic(PANIC_ASSERT_FAIL, "Active object priority already taken");
+
+	ao->kernel = k;
+	k->aos[ao->priority] = ao;
+
+	/* events posted before the start are served right away */
+	if (!ringbuf_empty(&ao->queue)) k->ready |= 1u << ao->priority;
+
+	irq_unlock();
+}
+
+/**
+ * @brief Runs handlers above the current ceiling, highest priority first, until none are left.
+ * @details Called again from inside a handler, this is what lets a higher priority object preempt on the same stack.
+ */
+static void ao_schedule(ao_kernel_t *k) {
+	const unsigned int ceiling = k->ceiling;
+
+	irq_lock();
+
+	/* everything at or above the ceiling is allowed to run */
+	while ((k->ready >> ceiling) != 0) {
+		const unsigned int prio = ao_highest(k->ready);
+		ao_t *ao = k->aos[prio];
+
+		const ao_event_t *evt;
+		ringbuf_pop(&ao->queue, &evt);
+		if (ringbuf_empty(&ao->queue)) k->ready &= ~(1u << prio);
+
+		k->ceiling = prio + 1;
+		irq_unlock();
+
+		ao->handler(ao, evt);
+		ao->dispatched++;
+
+		irq_lock();
+		k->ceiling = ceiling;
+	}
+
+	irq_unlock();
+}
+
+bool ao_post(ao_t *ao, const ao_event_t *evt) {
+	ao_kernel_t *k = ao->kernel;
+
+	irq_lock();
+
+	if (!ringbuf_push(&ao->queue, &evt)) {
+		ao->dropped++;
+		irq_unlock();
+		return false;
+	}
+
+	if (k == NULL) {
+		irq_unlock();
+		return true;
+	}
+
+	k->ready |= 1u << ao->priority;
+
+	/* a handler posting upwards preempts itself, anyone else leaves it to the host */
+	bool on_host = !(sched_p.state & SCHED_STATUS_IN_IRQ) &&
+		k->host != NULL && sched_p.sched_active_thread == (thread_impl_t *) &k->host->base;
+
+	irq_unlock();
+
+	if (on_host) {
+		if (ao->priority >= k->ceiling) ao_schedule(k);
+	} else if (k->host != NULL) {
+		notify_set_bits(k->host, 1);
+	}
+
+	return true;
+}
+
+int ao_kernel_run(void *arg) {
+	ao_kernel_t *k = (ao_kernel_t *) arg;
+
+	irq_lock();
+	k->host = container_of(sched_p.sched_active_thread, thread_t, base);
+	irq_unlock();
+
+	while (1) {
+		ao_schedule(k);
+
+		/* a post that slips in after the queues were drained leaves the notification set, so it isn't lost */
+		notify_wait();
+	}
+
+	return 0;
+}
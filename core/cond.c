@@ -0,0 +1,79 @@
+/*
+ * cond.c
+ *
+ *  Created on: Jul 3, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "cond.h"
+
+/**
+ * @brief Moves a signalled waiter over to the mutex it released.
+ * @details If the mutex is free the waiter is made the owner and woken, otherwise it keeps
+ * sleeping on the mutex wait queue and is woken later by mutex_unlock(). Either way the wait
+ * has been satisfied, so any timeout is disarmed.
+ */
+static void cond_requeue(mutex_t *mtx, thread_impl_t *waiter) {
+	if (mtx->owner == NULL) {
+		mtx->owner = container_of(waiter, thread_t, base);
+		sched_impl_wake(waiter, WAKE_SIGNALLED);
+	} else {
+		sched_impl_cancel_timeout(waiter);
+		waiter->status = STATUS_MUTEX_BLOCKED;
+		wait_queue_push(&mtx->waiters, waiter);
+	}
+}
+
+void cond_init(cond_t *cond) {
+	wait_queue_init(&cond->waiters);
+	cond->mtx = NULL;
+}
+
+bool cond_timedwait(cond_t *cond, mutex_t *mtx, unsigned int ms) {
+	irq_lock();
+
+	/* the critical section nests, so releasing the mutex and blocking happen as one step */
+	cond->mtx = mtx;
+	mutex_unlock(mtx);
+
+	/* when signalled, cond_requeue() made us the mutex owner before we were put back on the run queue */
+	bool signalled = (arch_wait_for(&cond->waiters, STATUS_COND_BLOCKED, ms) == WAKE_SIGNALLED);
+
+	/* on a timeout nobody handed the mutex back, so take it the normal way */
+	if (!signalled) mutex_lock(mtx);
+
+	irq_unlock();
+
+	return signalled;
+}
+
+void cond_wait(cond_t *cond, mutex_t *mtx) {
+	cond_timedwait(cond, mtx, SCHED_WAIT_FOREVER);
+}
+
+void cond_signal(cond_t *cond) {
+	irq_lock();
+
+	thread_impl_t *waiter = wait_queue_peek(&cond->waiters);
+	if (waiter != NULL) {
+		wait_queue_pop(&cond->waiters);
+		cond_requeue(cond->mtx, waiter);
+	}
+
+	irq_unlock();
+}
+
+void cond_broadcast(cond_t *cond) {
+	irq_lock();
+
+	/* wait morphing: at most one waiter becomes runnable, the rest queue up on the mutex */
+	thread_impl_t *waiter;
+	while ((waiter = wait_queue_peek(&cond->waiters)) != NULL) {
+		wait_queue_pop(&cond->waiters);
+		cond_requeue(cond->mtx, waiter);
+	}
+
+	irq_unlock();
+}
@@ -0,0 +1,181 @@
+/*
+ * coro.c
+ *
+ *  Created on: Jul 22, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "hal.h"
+#include "coro.h"
+
+void coro_init(coro_t *co, coro_fn_t fn) {
+	co->fn = fn;
+	co->next = NULL;
+	co->wobj = NULL;
+	co->lc = 0;
+	co->state = CORO_READY;
+	co->flags = 0;
+	co->result = CORO_OK;
+}
+
+void coro_host_init(coro_host_t *host) {
+	host->coros = NULL;
+	host->added = NULL;
+	sema_init(&host->kick, 0);
+}
+
+void coro_start(coro_host_t *host, coro_t *co) {
+	irq_lock();
+	co->next = host->added;
+	host->added = co;
+	irq_unlock();
+
+	coro_host_kick(host);
+}
+
+void coro_host_kick(coro_host_t *host) {
+	sema_post(&host->kick);
+}
+
+void coro_arm_delay(coro_t *co, unsigned int ms) {
+	co->wobj = NULL;
+	co->wake_time = arch_time_now() + arch_ms_to_cycles(ms);
+	co->state = CORO_WAITING;
+	co->flags = CORO_TIMED;
+	co->result = CORO_TIMEOUT;
+}
+
+void coro_arm_wait(coro_t *co, wait_obj_t *wobj, unsigned int ms) {
+	co->wobj = wobj;
+	co->state = CORO_WAITING;
+	co->flags = 0;
+
+	if (ms != SCHED_WAIT_FOREVER) {
+		co->wake_time = arch_time_now() + arch_ms_to_cycles(ms);
+		co->flags = CORO_TIMED;
+	}
+}
+
+/**
+ * @brief Checks whether a waiting coroutine can resume, consuming its object if it is ready.
+ */
+static bool coro_can_run(coro_t *co, unsigned int now) {
+	if (co->state == CORO_READY || (co->flags & CORO_POLL)) return true;
+
+	if (co->wobj != NULL && sched_wait_any(co->wobj, 1, 0) == 0) {
+		co->wobj = NULL;
+		co->result = CORO_OK;
+		return true;
+	}
+
+	if ((co->flags & CORO_TIMED) && (int) (co->wake_time - now) <= 0) {
+		co->wobj = NULL;
+		co->result = CORO_TIMEOUT;
+		return true;
+	}
+
+	return false;
+}
+
+int coro_host_run(void *arg) {
+	coro_host_t *host = (coro_host_t *) arg;
+
+	/* slot 0 is always the kick semaphore, the rest belong to waiting coroutines */
+	wait_obj_t set[CONFIG_WAIT_ANY_MAX];
+	coro_t *owners[CONFIG_WAIT_ANY_MAX];
+
+	while (1) {
+
+		/* take over everything started since the last pass */
+		irq_lock();
+		while (host->added != NULL) {
+			coro_t *co = host->added;
+			host->added = co->next;
+			co->next = host->coros;
+			host->coros = co;
+		}
+		irq_unlock();
+
+		set[0].type = WAIT_OBJ_SEMA;
+		set[0].obj = &host->kick;
+		set[0].arg = 0;
+
+		unsigned int n = 1;
+		unsigned int deadline = 0;
+		bool timed = false;
+		bool ready = false;
+		bool poll = false;
+
+		unsigned int now = arch_time_now();
+
+		coro_t **link = &host->coros;
+		while (*link != NULL) {
+			coro_t *co = *link;
+
+			if (coro_can_run(co, now)) {
+				co->state = CORO_READY;
+				co->flags = 0;
+				co->fn(co);
+			}
+
+			if (co->state == CORO_DONE) {
+				*link = co->next;
+				continue;
+			}
+
+			/* work out what the host has to wait for on this coroutine's behalf */
+			if (co->state == CORO_READY) {
+				ready = true;
+			} else if (co->flags & CORO_POLL) {
+				poll = true;
+			} else {
+				if (co->wobj != NULL) {
+					if (n < CONFIG_WAIT_ANY_MAX) {
+						set[n] = *co->wobj;
+						owners[n] = co;
+						n++;
+					} else {
+						poll = true;
+					}
+				}
+
+				if ((co->flags & CORO_TIMED) && (!timed || (int) (co->wake_time - deadline) < 0)) {
+					deadline = co->wake_time;
+					timed = true;
+				}
+			}
+
+			link = &co->next;
+		}
+
+		/* runnable coroutines only give other threads a turn */
+		if (ready) {
+			sched_yield();
+			continue;
+		}
+
+		unsigned int ms = SCHED_WAIT_FOREVER;
+		if (timed) {
+			int left = (int) (deadline - arch_time_now());
+			if (left <= 0) continue;
+
+			ms = arch_cycles_to_ms((unsigned int) left);
+		}
+
+		if (poll && ms > CONFIG_CORO_POLL_MS) ms = CONFIG_CORO_POLL_MS;
+
+		/* the object that fired was consumed on its owner's behalf, hand over the result */
+		int fired = sched_wait_any(set, n, ms);
+		if (fired > 0) {
+			coro_t *co = owners[fired];
+			co->wobj->arg = set[fired].arg;
+			co->wobj = NULL;
+			co->result = CORO_OK;
+			co->state = CORO_READY;
+		}
+	}
+
+	return 0;
+}
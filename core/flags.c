@@ -0,0 +1,74 @@
+/*
+ * flags.c
+ *
+ *  Created on: Jul 6, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "flags.h"
+
+static inline bool flags_satisfied(unsigned int bits, unsigned int mask, bool all) {
+	return all ? ((bits & mask) == mask) : ((bits & mask) != 0);
+}
+
+void flags_init(flags_t *flg) {
+	flg->bits = 0;
+	wait_queue_init(&flg->waiters);
+}
+
+void flags_set(flags_t *flg, unsigned int mask) {
+	irq_lock();
+
+	flg->bits |= mask;
+
+	/* every record holds its mask, only STATUS_FLAG_BLOCKED_ALL waiters need all of it */
+	wait_queue_entry_t *waiter = wait_queue_peek_entry(&flg->waiters);
+	while (waiter != NULL) {
+		wait_queue_entry_t *next = waiter->next;
+		bool all = (waiter->thr->status == STATUS_FLAG_BLOCKED_ALL);
+
+		if (flags_satisfied(flg->bits, (unsigned int) waiter->arg, all)) {
+			waiter->arg = flg->bits;	/* report the snapshot through the record */
+			sched_impl_wake_entry(waiter);
+		}
+
+		waiter = next;
+	}
+
+	irq_unlock();
+}
+
+void flags_clear(flags_t *flg, unsigned int mask) {
+	irq_lock();
+	flg->bits &= ~mask;
+	irq_unlock();
+}
+
+unsigned int flags_timedwait(flags_t *flg, unsigned int mask, bool all, unsigned int ms) {
+	unsigned int result = 0;
+
+	irq_lock();
+
+	if (flags_satisfied(flg->bits, mask, all)) {
+		result = flg->bits;
+	} else {
+		wait_queue_entry_t rec = { .que = &flg->waiters, .arg = mask };
+		unsigned int status = all ? STATUS_FLAG_BLOCKED_ALL : STATUS_FLAG_BLOCKED_ANY;
+
+		if (arch_wait_set_for(&rec, 1, status, ms) == WAKE_SIGNALLED) result = (unsigned int) rec.arg;
+	}
+
+	irq_unlock();
+
+	return result;
+}
+
+unsigned int flags_wait_any(flags_t *flg, unsigned int mask) {
+	return flags_timedwait(flg, mask, false, SCHED_WAIT_FOREVER);
+}
+
+unsigned int flags_wait_all(flags_t *flg, unsigned int mask) {
+	return flags_timedwait(flg, mask, true, SCHED_WAIT_FOREVER);
+}
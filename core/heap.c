@@ -0,0 +1,63 @@
+/*
+ * heap.c
+ *
+ *  Created on: Jul 19, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "heap.h"
+
+int heap_init(heap_t *heap, void *mem, size_t size) {
+	mutex_init(&heap->lock);
+	return tlsf_init(&heap->tlsf, mem, size);
+}
+
+void *heap_malloc(heap_t *heap, size_t size) {
+	mutex_lock(&heap->lock);
+	void *ptr = tlsf_malloc(&heap->tlsf, size);
+	mutex_unlock(&heap->lock);
+
+	return ptr;
+}
+
+void heap_free(heap_t *heap, void *ptr) {
+	if (ptr == NULL) return;
+
+	mutex_lock(&heap->lock);
+	tlsf_free(&heap->tlsf, ptr);
+	mutex_unlock(&heap->lock);
+}
+
+void heap_get_stats(heap_t *heap, heap_stats_t *stats) {
+	mutex_lock(&heap->lock);
+	tlsf_get_stats(&heap->tlsf, stats);
+	mutex_unlock(&heap->lock);
+}
+
+/*-----------------------------------------------------------*/
+
+#if (CONFIG_DYNAMIC_ALLOCATION == 1)
+
+static uint8_t heap_sys_mem[CONFIG_DYNAMIC_HEAP_SIZE] __attribute__((aligned(sizeof(void *))));
+static heap_t heap_sys;
+
+void heap_sys_init(void) {
+	if (heap_init(&heap_sys, heap_sys_mem, sizeof(heap_sys_mem)) != 0) {
+		panic(PANIC_ASSERT_FAIL, "CONFIG_DYNAMIC_HEAP_SIZE can't hold a heap");
+	}
+}
+
+void *heap_sys_malloc(size_t size) {
+	return heap_malloc(&heap_sys, size);
+}
+
+void heap_sys_free(void *ptr) {
+	heap_free(&heap_sys, ptr);
+}
+
+void heap_sys_get_stats(heap_stats_t *stats) {
+	heap_get_stats(&heap_sys, stats);
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * jobq.c
+ *
+ *  Created on: Jul 21, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "jobq.h"
+
+#define jobq_entry(ptr)		rb_entry((ptr), job_t, node)
+
+/**
+ * @brief Orders by priority, then oldest first among equals, so the highest pending job is the rightmost.
+ */
+static int jobq_job_cmp(const void *left, const void *right) {
+	job_t *a = jobq_entry((rbnode *) left);
+	job_t *b = jobq_entry((rbnode *) right);
+
+	if (a->priority != b->priority) return (a->priority > b->priority) ? 1 : -1;
+	return (int) (b->seq - a->seq);
+}
+
+void job_init(job_t *job) {
+	job->queued = false;
+}
+
+void jobq_init(jobq_t *q) {
+	rbtree_rcached_init(&q->jobs);
+	q->seq = 0;
+	wait_queue_init(&q->idle);
+
+	q->depth = 0;
+	q->depth_max = 0;
+	q->submitted = 0;
+	q->completed = 0;
+	q->latency_total = 0;
+	q->latency_max = 0;
+	q->run_total = 0;
+	q->run_max = 0;
+}
+
+int jobq_worker(void *arg) {
+	jobq_t *q = (jobq_t *) arg;
+
+	while (1) {
+		irq_lock();
+
+		/* another worker may have taken the job this one was woken for */
+		while (RB_NULL_ROOT(&q->jobs.tree)) {
+			arch_wait_for(&q->idle, STATUS_RECEIVE_BLOCKED, SCHED_WAIT_FOREVER);
+		}
+
+		job_t *job = jobq_entry(rb_last_cached(&q->jobs));
+		rb_rcached_delete(&q->jobs, &job->node);
+		job->queued = false;
+		q->depth--;
+
+		unsigned int start = arch_time_now();
+		unsigned int latency = start - job->submit_time;
+		q->latency_total += latency;
+		if (latency > q->latency_max) q->latency_max = latency;
+
+		irq_unlock();
+
+		job->fn(job);
+
+		unsigned int run = arch_time_now() - start;
+
+		irq_lock();
+		q->completed++;
+		q->run_total += run;
+		if (run > q->run_max) q->run_max = run;
+		irq_unlock();
+	}
+
+	return 0;
+}
+
+unsigned int jobq_spawn(jobq_t *q, unsigned int n, size_t stack_size, unsigned int shares) {
+	unsigned int spawned = 0;
+
+	while (spawned < n && thread_create(jobq_worker, q, stack_size, shares) != NULL) {
+		spawned++;
+	}
+
+	return spawned;
+}
+
+bool jobq_submit(jobq_t *q, job_t *job, job_fn_t fn, unsigned int priority) {
+	irq_lock();
+
+	if (job->queued) {
+		irq_unlock();
+		return false;
+	}
+
+	job->fn = fn;
+	job->priority = priority;
+	job->seq = q->seq++;
+	job->submit_time = arch_time_now();
+	job->queued = true;
+
+	rbnode_init(&job->node);
+	rb_rcached_insert(&q->jobs, &job->node, jobq_job_cmp);
+
+	q->submitted++;
+	if (++q->depth > q->depth_max) q->depth_max = q->depth;
+
+	/* one job needs one worker */
+	thread_impl_t *worker = wait_queue_peek(&q->idle);
+	if (worker != NULL) sched_impl_wake(worker, WAKE_SIGNALLED);
+
+	irq_unlock();
+
+	return true;
+}
+
+bool jobq_cancel(jobq_t *q, job_t *job) {
+	bool cancelled = false;
+
+	irq_lock();
+
+	if (job->queued) {
+		rb_rcached_delete(&q->jobs, &job->node);
+		job->queued = false;
+		q->depth--;
+		cancelled = true;
+	}
+
+	irq_unlock();
+
+	return cancelled;
+}
@@ -0,0 +1,74 @@
+/*
+ * mbox.c
+ *
+ *  Created on: Jul 6, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "mbox.h"
+
+void mbox_init(mbox_t *mbox, void **slots, unsigned int size) {
+	mbox->slots = slots;
+	mbox->size = size;
+	mbox->head = 0;
+	mbox->count = 0;
+	wait_queue_init(&mbox->receivers);
+}
+
+bool mbox_put(mbox_t *mbox, void *msg) {
+	bool delivered = true;
+
+	irq_lock();
+
+	/* a waiting receiver only exists when the mailbox is empty, so hand the message over directly */
+	wait_queue_entry_t *receiver = wait_queue_peek_entry(&mbox->receivers);
+	if (receiver != NULL) {
+		*((void **) receiver->arg) = msg;
+		sched_impl_wake_entry(receiver);
+	} else if (mbox->count < mbox->size) {
+		unsigned int tail = mbox->head + mbox->count;
+		if (tail >= mbox->size) tail -= mbox->size;
+
+		mbox->slots[tail] = msg;
+		mbox->count++;
+	} else {
+		delivered = false;
+	}
+
+	irq_unlock();
+
+	return delivered;
+}
+
+bool mbox_timedget(mbox_t *mbox, void **msg, unsigned int ms) {
+	bool received = true;
+
+	irq_lock();
+
+	if (mbox->count > 0) {
+		*msg = mbox->slots[mbox->head];
+		if (++mbox->head == mbox->size) mbox->head = 0;
+		mbox->count--;
+	} else {
+
+		/* the record lives on our stack for as long as we are blocked */
+		wait_queue_entry_t rec = { .que = &mbox->receivers, .arg = (uintptr_t) msg };
+		if (arch_wait_set_for(&rec, 1, STATUS_MBOX_BLOCKED, ms) != WAKE_SIGNALLED) received = false;
+	}
+
+	irq_unlock();
+
+	return received;
+}
+
+void *mbox_get(mbox_t *mbox) {
+	void *msg = NULL;
+	mbox_timedget(mbox, &msg, SCHED_WAIT_FOREVER);
+	return msg;
+}
+
+bool mbox_tryget(mbox_t *mbox, void **msg) {
+	return mbox_timedget(mbox, msg, 0);
+}
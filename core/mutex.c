@@ -0,0 +1,59 @@
+/*
+ * mutex.c
+ *
+ *  Created on: Jul 3, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "mutex.h"
+
+#define mutex_self()	container_of(sched_p.sched_active_thread, thread_t, base)
+
+void mutex_init(mutex_t *mtx) {
+	mtx->owner = NULL;
+	wait_queue_init(&mtx->waiters);
+}
+
+bool mutex_timedlock(mutex_t *mtx, unsigned int ms) {
+	bool taken = true;
+
+	irq_lock();
+
+	if (mtx->owner == NULL) {
+		mtx->owner = mutex_self();
+
+	/* queue up and switch away, mutex_unlock() hands over ownership before waking us */
+	} else if (arch_wait_for(&mtx->waiters, STATUS_MUTEX_BLOCKED, ms) != WAKE_SIGNALLED) {
+		taken = false;
+	}
+
+	irq_unlock();
+
+	return taken;
+}
+
+void mutex_lock(mutex_t *mtx) {
+	mutex_timedlock(mtx, SCHED_WAIT_FOREVER);
+}
+
+bool mutex_trylock(mutex_t *mtx) {
+	return mutex_timedlock(mtx, 0);
+}
+
+void mutex_unlock(mutex_t *mtx) {
+	irq_lock();
+
+	if (mtx->owner != mutex_self()) panic(PANIC_ASSERT_FAIL, "Mutex unlocked by non-owner");
+
+	thread_impl_t *next_owner = wait_queue_peek(&mtx->waiters);
+	if (next_owner == NULL) {
+		mtx->owner = NULL;
+	} else {
+		mtx->owner = container_of(next_owner, thread_t, base);
+		sched_impl_wake(next_owner, WAKE_SIGNALLED);
+	}
+
+	irq_unlock();
+}
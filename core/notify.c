@@ -0,0 +1,60 @@
+/*
+ * notify.c
+ *
+ *  Created on: Jul 8, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "notify.h"
+
+/**
+ * @brief Wakes the thread if it is waiting on its notification word and the word became nonzero.
+ */
+static inline void notify_wake(thread_t *thr) {
+	if (thr->base.status == STATUS_NOTIFY_BLOCKED && thr->notify != 0) {
+		sched_impl_wake(&thr->base, WAKE_SIGNALLED);
+	}
+}
+
+void notify_set_bits(thread_t *thr, unsigned int bits) {
+	irq_lock();
+	thr->notify |= bits;
+	notify_wake(thr);
+	irq_unlock();
+}
+
+void notify_increment(thread_t *thr) {
+	irq_lock();
+	thr->notify++;
+	notify_wake(thr);
+	irq_unlock();
+}
+
+void notify_overwrite(thread_t *thr, unsigned int value) {
+	irq_lock();
+	thr->notify = value;
+	notify_wake(thr);
+	irq_unlock();
+}
+
+unsigned int notify_timedwait(unsigned int ms) {
+	thread_t *me = container_of(sched_p.sched_active_thread, thread_t, base);
+
+	irq_lock();
+
+	/* an empty wait set: only a notification or the timeout can wake us */
+	if (me->notify == 0) arch_wait_set_for(NULL, 0, STATUS_NOTIFY_BLOCKED, ms);
+
+	unsigned int value = me->notify;
+	me->notify = 0;
+
+	irq_unlock();
+
+	return value;
+}
+
+unsigned int notify_wait(void) {
+	return notify_timedwait(SCHED_WAIT_FOREVER);
+}
@@ -0,0 +1,92 @@
+/*
+ * pbuf.c
+ *
+ *  Created on: Jul 15, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "pbuf.h"
+
+void pbuf_pool_init(pbuf_pool_t *pool) {
+	const unsigned int stride = PBUF_BLOCK_SIZE(pool->payload_size);
+
+	pool->free = NULL;
+
+	/* push blocks back to front so allocation walks storage in address order */
+	for (unsigned int i = pool->num_blocks; i > 0; --i) {
+		pbuf_t *pb = (pbuf_t *) (pool->storage + ((i - 1) * stride));
+
+		pb->pool = pool;
+		pb->refs = 0;
+		pb->next = pool->free;
+		pool->free = pb;
+	}
+
+	pool->num_free = pool->num_blocks;
+}
+
+pbuf_t *pbuf_alloc(pbuf_pool_t *pool) {
+	irq_lock();
+
+	pbuf_t *pb = pool->free;
+	if (pb != NULL) {
+		pool->free = pb->next;
+		pool->num_free--;
+	}
+
+	irq_unlock();
+
+	if (pb != NULL) {
+		pb->next = NULL;
+		pb->refs = 1;
+		pb->len = 0;
+	}
+
+	return pb;
+}
+
+void pbuf_ref(pbuf_t *pb) {
+	irq_lock();
+	pb->refs++;
+	irq_unlock();
+}
+
+void pbuf_unref(pbuf_t *pb) {
+	irq_lock();
+
+	/* walk the chain until a block that is still shared by another packet */
+	while (pb != NULL) {
+		if (pb->refs == 0) panic(PANIC_ASSERT_FAIL, "pbuf released more times than referenced");
+		if (--pb->refs > 0) break;
+
+		pbuf_t *next = pb->next;
+		pbuf_pool_t *pool = pb->pool;
+
+		pb->next = pool->free;
+		pool->free = pb;
+		pool->num_free++;
+
+		pb = next;
+	}
+
+	irq_unlock();
+}
+
+void pbuf_chain(pbuf_t *head, pbuf_t *tail) {
+	while (head->next != NULL) {
+		head = head->next;
+	}
+
+	head->next = tail;
+}
+
+unsigned int pbuf_total_len(const pbuf_t *pb) {
+	unsigned int len = 0;
+
+	for (; pb != NULL; pb = pb->next) {
+		len += pb->len;
+	}
+
+	return len;
+}
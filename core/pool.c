@@ -0,0 +1,138 @@
+/*
+ * pool.c
+ *
+ *  Created on: Jul 18, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "pool.h"
+
+void pool_init(pool_t *pool, void *storage, unsigned int block_size, unsigned int num_blocks) {
+	const unsigned int stride = POOL_BLOCK_SIZE(block_size);
+
+	pool->free = NULL;
+	pool->block_size = stride;
+	pool->num_blocks = num_blocks;
+	pool->start = (uint8_t *) storage;
+	pool->end = pool->start + (stride * num_blocks);
+
+	/* push blocks back to front so allocation walks storage in address order */
+	for (unsigned int i = num_blocks; i > 0; --i) {
+		pool_block_t *blk = (pool_block_t *) (pool->start + ((i - 1) * stride));
+
+		blk->next = pool->free;
+		pool->free = blk;
+	}
+
+	pool->num_free = num_blocks;
+	pool->min_free = num_blocks;
+}
+
+void *pool_alloc(pool_t *pool) {
+	irq_lock();
+
+	pool_block_t *blk = pool->free;
+	if (blk != NULL) {
+		pool->free = blk->next;
+		pool->num_free--;
+		if (pool->num_free < pool->min_free) pool->min_free = pool->num_free;
+	}
+
+	irq_unlock();
+
+	return blk;
+}
+
+void pool_free(pool_t *pool, void *block) {
+	uint8_t *p = (uint8_t *) block;
+
+	if (p < pool->start || p >= pool->end || ((p - pool->start) % pool->block_size) != 0) {
+		panic(PANIC_ASSERT_FAIL, "Block doesn't belong to this pool");
+	}
+
+	irq_lock();
+
+	pool_block_t *blk = (pool_block_t *) block;
+	blk->next = pool->free;
+	pool->free = blk;
+	pool->num_free++;
+
+	irq_unlock();
+}
+
+void pool_get_stats(pool_t *pool, pool_stats_t *stats) {
+	irq_lock();
+
+	stats->block_size = pool->block_size;
+	stats->num_blocks = pool->num_blocks;
+	stats->in_use = pool->num_blocks - pool->num_free;
+	stats->peak = pool->num_blocks - pool->min_free;
+
+	irq_unlock();
+}
+
+/*-----------------------------------------------------------*/
+
+#if (CONFIG_STATIC_ALLOCATION == 1)
+
+/* the heap holds every class back to back, each one num * POOL_BLOCK_SIZE(size) bytes */
+#define POOL_CLASS(size, num)	+ ((num) * POOL_BLOCK_SIZE(size))
+_Static_assert((0 CONFIG_STATIC_POOL_CLASSES) <= CONFIG_STATIC_HEAP_SIZE,
+			   "CONFIG_STATIC_POOL_CLASSES don't fit in CONFIG_STATIC_HEAP_SIZE");
+#undef POOL_CLASS
+
+#define POOL_CLASS(size, num)	+ 1
+enum { POOL_SYS_NUM_CLASSES = 0 CONFIG_STATIC_POOL_CLASSES };
+#undef POOL_CLASS
+
+static uint8_t pool_sys_heap[CONFIG_STATIC_HEAP_SIZE] __attribute__((aligned(sizeof(void *))));
+static pool_t pool_sys_classes[POOL_SYS_NUM_CLASSES];
+
+void pool_sys_init(void) {
+	uint8_t *storage = pool_sys_heap;
+	pool_t *cls = pool_sys_classes;
+
+	#define POOL_CLASS(size, num)										\
+		pool_init(cls, storage, (size), (num));							\
+		storage = cls->end;												\
+		cls++;
+
+	CONFIG_STATIC_POOL_CLASSES
+
+	#undef POOL_CLASS
+}
+
+void *pool_sys_alloc(size_t size) {
+	for (unsigned int i = 0; i < POOL_SYS_NUM_CLASSES; ++i) {
+		if (pool_sys_classes[i].block_size < size) continue;
+
+		void *block = pool_alloc(&pool_sys_classes[i]);
+		if (block != NULL) return block;
+	}
+
+	return NULL;
+}
+
+void pool_sys_free(void *block) {
+	uint8_t *p = (uint8_t *) block;
+
+	/* classes are laid out in order, so the owner is the first one ending past the block */
+	for (unsigned int i = 0; i < POOL_SYS_NUM_CLASSES; ++i) {
+		if (p < pool_sys_classes[i].end) {
+			pool_free(&pool_sys_classes[i], block);
+			return;
+		}
+	}
+
+	panic(PANIC_ASSERT_FAIL, "Block isn't from the system heap");
+}
+
+int pool_sys_get_stats(unsigned int cls, pool_stats_t *stats) {
+	if (cls >= POOL_SYS_NUM_CLASSES) return -1;
+
+	pool_get_stats(&pool_sys_classes[cls], stats);
+	return 0;
+}
+
+#endif
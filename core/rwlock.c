@@ -0,0 +1,122 @@
+/*
+ * rwlock.c
+ *
+ *  Created on: Jul 9, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "rwlock.h"
+
+#define rwlock_self()	container_of(sched_p.sched_active_thread, thread_t, base)
+
+/**
+ * @brief Checks if a new reader may enter: no writer inside or waiting, and room under the bound.
+ */
+static inline bool rwlock_read_admissible(rwlock_t *rw) {
+	return rw->writer == NULL && wait_queue_empty(&rw->write_waiters) && rw->readers < rw->max_readers;
+}
+
+/**
+ * @brief Hands the lock to whoever is next. Waiting writers go first, otherwise as many readers as the bound allows.
+ * @details Woken threads already hold the lock when they run.
+ */
+static void rwlock_handoff(rwlock_t *rw) {
+	if (rw->writer != NULL) return;
+
+	thread_impl_t *next = wait_queue_peek(&rw->write_waiters);
+	if (next != NULL) {
+		if (rw->readers == 0) {
+			rw->writer = container_of(next, thread_t, base);
+			sched_impl_wake(next, WAKE_SIGNALLED);
+		}
+		return;
+	}
+
+	while (rw->readers < rw->max_readers && (next = wait_queue_peek(&rw->read_waiters)) != NULL) {
+		rw->readers++;
+		sched_impl_wake(next, WAKE_SIGNALLED);
+	}
+}
+
+void rwlock_init(rwlock_t *rw, unsigned int max_readers) {
+	rw->readers = 0;
+	rw->max_readers = max_readers;
+	rw->writer = NULL;
+	wait_queue_init(&rw->read_waiters);
+	wait_queue_init(&rw->write_waiters);
+}
+
+bool rwlock_timedrdlock(rwlock_t *rw, unsigned int ms) {
+	bool taken = true;
+
+	irq_lock();
+
+	if (rwlock_read_admissible(rw)) {
+		rw->readers++;
+	} else if (arch_wait_for(&rw->read_waiters, STATUS_RWLOCK_BLOCKED, ms) != WAKE_SIGNALLED) {
+		taken = false;
+	}
+
+	irq_unlock();
+
+	return taken;
+}
+
+void rwlock_rdlock(rwlock_t *rw) {
+	rwlock_timedrdlock(rw, SCHED_WAIT_FOREVER);
+}
+
+bool rwlock_tryrdlock(rwlock_t *rw) {
+	return rwlock_timedrdlock(rw, 0);
+}
+
+void rwlock_rdunlock(rwlock_t *rw) {
+	irq_lock();
+
+	if (rw->readers == 0) panic(PANIC_ASSERT_FAIL, "Read unlock of an rwlock with no readers");
+
+	rw->readers--;
+	rwlock_handoff(rw);
+
+	irq_unlock();
+}
+
+bool rwlock_timedwrlock(rwlock_t *rw, unsigned int ms) {
+	bool taken = true;
+
+	irq_lock();
+
+	if (rw->writer == NULL && rw->readers == 0) {
+		rw->writer = rwlock_self();
+	} else if (arch_wait_for(&rw->write_waiters, STATUS_RWLOCK_BLOCKED, ms) != WAKE_SIGNALLED) {
+		taken = false;
+
+		/* readers held back for our sake can come in now */
+		rwlock_handoff(rw);
+	}
+
+	irq_unlock();
+
+	return taken;
+}
+
+void rwlock_wrlock(rwlock_t *rw) {
+	rwlock_timedwrlock(rw, SCHED_WAIT_FOREVER);
+}
+
+bool rwlock_trywrlock(rwlock_t *rw) {
+	return rwlock_timedwrlock(rw, 0);
+}
+
+void rwlock_wrunlock(rwlock_t *rw) {
+	irq_lock();
+
+	if (rw->writer != rwlock_self()) panic(PANIC_ASSERT_FAIL, "Write unlock of an rwlock by non-writer");
+
+	rw->writer = NULL;
+	rwlock_handoff(rw);
+
+	irq_unlock();
+}
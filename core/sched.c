@@ -9,9 +9,44 @@
 #include "sched_impl.h"
 #include "sched.h"
 
+/* bounds of the THREAD_DEFINE() table, provided by the linker and NULL if no thread was defined */
+extern const thread_def_t __start_thread_defs[] __attribute__((weak));
+extern const thread_def_t __stop_thread_defs[] __attribute__((weak));
+
+/**
+ * @brief Adds every THREAD_DEFINE() thread. TCBs are zeroed as .bss, so only the context needs filling in.
+ */
+static void sched_init_static_threads(void) {
+	sched_impl_batch_t batch;
+	sched_impl_batch_init(&batch);
+
+	for (const thread_def_t *def = __start_thread_defs; def < __stop_thread_defs; ++def) {
+		thread_t *thr = def->thr;
+
+		#if (ARCH_HAS_CONTEXT_INIT == 1)
+			#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+				thread_impl_stack_init(&thr->base, def->stack, def->stack_size);
+			#endif
+
+			arch_context_t *ctx = (arch_context_t *) (def->stack + def->stack_size - sizeof(arch_context_t));
+			*ctx = def->ctx;
+			thr->base.sp = ctx;
+			thr->base.frame = ARCH_FRAME_FULL;
+			thr->cs_lock = 1;
+		#else
+			thread_init(thr, def->fn, def->arg, def->stack, def->stack_size);
+		#endif
+
+		sched_impl_batch_add(&batch, &thr->base, def->shares);
+	}
+
+	sched_impl_add_batch(&batch);
+}
+
 void sched_init(void) {
 	irq_disable();
 	sched_impl_init();
+	sched_init_static_threads();
 	irq_enable();
 }
 
@@ -21,6 +56,21 @@ void sched_add(volatile thread_t *new, volatile unsigned int priority) {
 	irq_unlock();
 }
 
+void sched_add_batch(thread_t *const *threads, const unsigned int *priorities, unsigned int n) {
+	irq_lock();
+
+	sched_impl_batch_t batch;
+	sched_impl_batch_init(&batch);
+
+	for (unsigned int i = 0; i < n; ++i) {
+		sched_impl_batch_add(&batch, &threads[i]->base, priorities[i]);
+	}
+
+	sched_impl_add_batch(&batch);
+
+	irq_unlock();
+}
+
 void sched_register(volatile thread_t *new) {
 	irq_lock();
 	sched_impl_register((thread_impl_t *) &new->base);
@@ -63,12 +113,116 @@ void sched_yield_higher(void) {
 	irq_unlock();
 }
 
+bool sched_switch_to(thread_t *thr) {
+	irq_lock();
+
+	/* only a thread on the run queue can take over the slice */
+	thread_impl_t *target = &thr->base;
+	bool handed_off = (target->status >= STATUS_RUNNING) && (target != sched_p.sched_active_thread);
+	if (handed_off) arch_switch_to(target);
+
+	irq_unlock();
+
+	return handed_off;
+}
+
 void sched_sleep(unsigned int ms) {
 	irq_lock();
 	arch_sleep_for(ms);
 	irq_unlock();
 }
 
+void sched_task_exit(int exit_code) {
+	irq_lock();
+
+	thread_t *me = container_of(sched_p.sched_active_thread, thread_t, base);
+	me->exit_code = exit_code;
+
+	/* off the run queue for good, the joiner releases the TCB and stack once this context is saved */
+	sched_impl_block(STATUS_ZOMBIE);
+
+	thread_impl_t *joiner = wait_queue_peek(&me->joiners);
+	if (joiner != NULL) sched_impl_wake(joiner, WAKE_SIGNALLED);
+
+	arch_yield();
+
+	while (1) {
+		panic(PANIC_UNDEFINED, "Zombie thread was scheduled");
+	}
+}
+
+/**
+ * @brief Consumes an object without blocking, if it is ready.
+ */
+static bool sched_wait_obj_try(wait_obj_t *wobj) {
+	switch (wobj->type) {
+		case WAIT_OBJ_SEMA:
+			return sema_trywait((sema_t *) wobj->obj);
+
+		case WAIT_OBJ_MBOX:
+			return mbox_tryget((mbox_t *) wobj->obj, (void **) wobj->arg);
+
+		case WAIT_OBJ_FLAGS: {
+			unsigned int bits = flags_timedwait((flags_t *) wobj->obj, (unsigned int) wobj->arg, false, 0);
+			if (bits == 0) return false;
+
+			wobj->arg = bits;
+			return true;
+		}
+
+		default:
+			panic(PANIC_ASSERT_FAIL, "Unknown object type passed to sched_wait_any()");
+	}
+}
+
+/**
+ * @brief Finds the wait queue a wait record has to be linked into for an object.
+ */
+static wait_queue_t *sched_wait_obj_queue(wait_obj_t *wobj) {
+	switch (wobj->type) {
+		case WAIT_OBJ_SEMA: return &((sema_t *) wobj->obj)->waiters;
+		case WAIT_OBJ_MBOX: return &((mbox_t *) wobj->obj)->receivers;
+		case WAIT_OBJ_FLAGS: return &((flags_t *) wobj->obj)->waiters;
+		default: panic(PANIC_ASSERT_FAIL, "Unknown object type passed to sched_wait_any()");
+	}
+}
+
+int sched_wait_any(wait_obj_t *objs, unsigned int n, unsigned int ms) {
+	wait_queue_entry_t set[CONFIG_WAIT_ANY_MAX];
+	int ready = -1;
+
+	if (n > CONFIG_WAIT_ANY_MAX) panic(PANIC_ASSERT_FAIL, "Too many objects passed to sched_wait_any()");
+
+	irq_lock();
+
+	/* anything that is already ready is consumed without arming a single record */
+	for (unsigned int i = 0; i < n; ++i) {
+		if (sched_wait_obj_try(&objs[i])) {
+			ready = i;
+			break;
+		}
+	}
+
+	if (ready < 0) {
+
+		/* one record per object, all on this stack frame, which outlives the wait */
+		for (unsigned int i = 0; i < n; ++i) {
+			set[i].que = sched_wait_obj_queue(&objs[i]);
+			set[i].arg = objs[i].arg;
+		}
+
+		/* the object that fired completed the operation on our behalf before waking us */
+		if (arch_wait_set_for(set, n, STATUS_MULTI_BLOCKED, ms) == WAKE_SIGNALLED) {
+			ready = sched_p.sched_active_thread->wake_index;
+			objs[ready].arg = set[ready].arg;
+		}
+	}
+
+	irq_unlock();
+
+	return ready;
+}
+
 sched_status_t sched_get_status(void) {
 //	arch_disable_interrupts();
 //	sched_status_t state = sched_g.state;
@@ -101,3 +255,10 @@ thread_t *sched_current_thread() {
 
 //	return curr;
 }
+
+void sched_get_switch_stats(sched_switch_stats_t *stats) {
+	irq_lock();
+	stats->switches = sched_p.switches;
+	stats->skipped = sched_p.switches_skipped;
+	irq_unlock();
+}
@@ -0,0 +1,51 @@
+/*
+ * sema.c
+ *
+ *  Created on: Jul 6, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "sema.h"
+
+void sema_init(sema_t *sem, unsigned int count) {
+	sem->count = count;
+	wait_queue_init(&sem->waiters);
+}
+
+bool sema_timedwait(sema_t *sem, unsigned int ms) {
+	bool taken = true;
+
+	irq_lock();
+
+	if (sem->count > 0) {
+		sem->count--;
+
+	/* sema_post() passes its count to us directly instead of incrementing */
+	} else if (arch_wait_for(&sem->waiters, STATUS_SEMA_BLOCKED, ms) != WAKE_SIGNALLED) {
+		taken = false;
+	}
+
+	irq_unlock();
+
+	return taken;
+}
+
+void sema_wait(sema_t *sem) {
+	sema_timedwait(sem, SCHED_WAIT_FOREVER);
+}
+
+bool sema_trywait(sema_t *sem) {
+	return sema_timedwait(sem, 0);
+}
+
+void sema_post(sema_t *sem) {
+	irq_lock();
+
+	wait_queue_entry_t *waiter = wait_queue_peek_entry(&sem->waiters);
+	if (waiter != NULL) sched_impl_wake_entry(waiter);
+	else sem->count++;
+
+	irq_unlock();
+}
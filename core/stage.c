@@ -0,0 +1,146 @@
+/*
+ * stage.c
+ *
+ *  Created on: Jul 17, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "stage.h"
+
+#ifndef min
+#define min(a,b) \
+  ({ __typeof__ (a) _a = (a); \
+      __typeof__ (b) _b = (b); \
+    _a < _b ? _a : _b; })
+#endif
+
+/**
+ * @brief Stage thread body. Waits for a batch, runs the handler on it in place, then frees the slots.
+ */
+static int stage_thread(void *arg) {
+	stage_t *st = (stage_t *) arg;
+
+	while (1) {
+		irq_lock();
+
+		/* a timeout with a partial batch queued still gets processed */
+		if (st->count < st->batch) {
+			arch_wait_for(&st->consumer, STATUS_RECEIVE_BLOCKED, st->flush_ms);
+		}
+
+		/* only the part of the batch up to the end of storage is contiguous */
+		unsigned int n = min(min(st->count, st->batch), st->size - st->head);
+		void **items = &st->slots[st->head];
+
+		irq_unlock();
+
+		if (n == 0) continue;
+
+		/* producers only write free slots, so the handler can read these without the lock */
+		st->fn(st, items, n);
+
+		irq_lock();
+
+		st->head += n;
+		if (st->head == st->size) st->head = 0;
+		st->count -= n;
+
+		st->items += n;
+		st->batches++;
+
+		/* release as many blocked producers as there is room for now */
+		thread_impl_t *producer;
+		for (unsigned int room = n; room > 0 && (producer = wait_queue_peek(&st->producers)) != NULL; --room) {
+			sched_impl_wake(producer, WAKE_SIGNALLED);
+		}
+
+		irq_unlock();
+	}
+
+	return 0;
+}
+
+void stage_init(stage_t *st, void **slots, unsigned int size, unsigned int batch,
+				unsigned int flush_ms, stage_fn_t fn, void *ctx) {
+	if (batch == 0 || batch > size) panic(PANIC_ASSERT_FAIL, "Stage batch must fit in its queue");
+
+	/* a zero flush would have the stage thread spin on an empty queue */
+	if (flush_ms == 0) panic(PANIC_ASSERT_FAIL, "Stage flush time must be nonzero");
+
+	st->slots = slots;
+	st->size = size;
+	st->head = 0;
+	st->count = 0;
+
+	st->batch = batch;
+	st->flush_ms = flush_ms;
+	st->fn = fn;
+	st->ctx = ctx;
+
+	wait_queue_init(&st->consumer);
+	wait_queue_init(&st->producers);
+
+	st->items = 0;
+	st->batches = 0;
+	st->stalls = 0;
+	st->depth_max = 0;
+}
+
+void stage_spawn(stage_t *st, thread_t *thr, void *stack, size_t stack_size, unsigned int shares) {
+	thread_init(thr, stage_thread, st, stack, stack_size);
+	sched_add(thr, shares);
+}
+
+bool stage_timedpush(stage_t *st, void *item, unsigned int ms) {
+	bool queued = true;
+	bool timed = (ms != 0 && ms != SCHED_WAIT_FOREVER);
+
+	irq_lock();
+
+	/* retries only get what is left of the original timeout */
+	unsigned int deadline = timed ? arch_time_now() + arch_ms_to_cycles(ms) : 0;
+
+	/* backpressure: wait for the stage thread to free a slot, retrying in case another producer took it */
+	while (st->count == st->size) {
+		unsigned int left = ms;
+		if (timed) {
+			int cycles = (int) (deadline - arch_time_now());
+			left = (cycles > 0) ? arch_cycles_to_ms((unsigned int) cycles) : 0;
+		}
+
+		st->stalls++;
+		if (arch_wait_for(&st->producers, STATUS_SEND_BLOCKED, left) != WAKE_SIGNALLED) {
+			queued = false;
+			break;
+		}
+	}
+
+	if (queued) {
+		unsigned int tail = st->head + st->count;
+		if (tail >= st->size) tail -= st->size;
+
+		st->slots[tail] = item;
+		st->count++;
+		if (st->count > st->depth_max) st->depth_max = st->count;
+
+		/* the stage thread only wakes per batch */
+		if (st->count >= st->batch) {
+			thread_impl_t *consumer = wait_queue_peek(&st->consumer);
+			if (consumer != NULL) sched_impl_wake(consumer, WAKE_SIGNALLED);
+		}
+	}
+
+	irq_unlock();
+
+	return queued;
+}
+
+void stage_push(stage_t *st, void *item) {
+	stage_timedpush(st, item, SCHED_WAIT_FOREVER);
+}
+
+unsigned int stage_depth(stage_t *st) {
+	return st->count;
+}
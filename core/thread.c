@@ -0,0 +1,96 @@
+/*
+ * thread.c
+ *
+ *  Created on: Jul 20, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "thread.h"
+
+#if (CONFIG_STATIC_ALLOCATION == 1)
+	#define thread_mem_alloc(size)		pool_sys_alloc(size)
+	#define thread_mem_free(ptr)		pool_sys_free(ptr)
+#elif (CONFIG_DYNAMIC_ALLOCATION == 1)
+	#define thread_mem_alloc(size)		heap_sys_malloc(size)
+	#define thread_mem_free(ptr)		heap_sys_free(ptr)
+#endif
+
+void thread_init(thread_t *thr, thread_fn_t fn, void *arg, void *stack, size_t stack_size) {
+	thread_impl_init(&thr->base, stack, stack_size, fn, arg);
+
+	thr->cs_lock = 1;
+	thr->notify = 0;
+	thr->exit_code = 0;
+	wait_queue_init(&thr->joiners);
+	thr->stack = NULL;
+}
+
+#ifdef thread_mem_alloc
+
+thread_t *thread_create(thread_fn_t fn, void *arg, size_t stack_size, unsigned int shares) {
+	thread_t *thr = thread_mem_alloc(sizeof(thread_t));
+	void *stack = thread_mem_alloc(stack_size);
+
+	if (thr == NULL || stack == NULL) {
+		if (thr != NULL) thread_mem_free(thr);
+		if (stack != NULL) thread_mem_free(stack);
+		return NULL;
+	}
+
+	thread_init(thr, fn, arg, stack, stack_size);
+	thr->stack = stack;
+
+	sched_add(thr, shares);
+
+	return thr;
+}
+
+#endif
+
+void thread_exit(int exit_code) {
+	sched_task_exit(exit_code);
+}
+
+int thread_join(thread_t *thr) {
+	irq_lock();
+
+	if (thr->base.status != STATUS_ZOMBIE) {
+		if (!wait_queue_empty(&thr->joiners)) panic(PANIC_ASSERT_FAIL, "Thread joined twice");
+
+		/* sched_task_exit() wakes us once the thread is a zombie */
+		arch_wait_for(&thr->joiners, STATUS_JOIN_BLOCKED, SCHED_WAIT_FOREVER);
+	}
+
+	int exit_code = thr->exit_code;
+
+	irq_unlock();
+
+	/* the stack is no longer in use, whoever owns it */
+	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+		thread_impl_stack_release(&thr->base);
+	#endif
+
+	#ifdef thread_mem_alloc
+		/* the zombie's context was saved on the way out and is never restored, so the stack is free */
+		if (thr->stack != NULL) {
+			thread_mem_free(thr->stack);
+			thread_mem_free(thr);
+		}
+	#endif
+
+	return exit_code;
+}
+
+#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+
+size_t thread_stack_high_water(thread_t *thr) {
+	return thr->base.stack_high_water;
+}
+
+size_t thread_stack_size(thread_t *thr) {
+	return thr->base.stack_size;
+}
+
+#endif
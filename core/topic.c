@@ -0,0 +1,82 @@
+/*
+ * topic.c
+ *
+ *  Created on: Jul 13, 2020
+ *      Author: krad2
+ */
+
+#include <string.h>
+
+#include "rtos.h"
+#include "sched_impl.h"
+#include "topic.h"
+
+/* keeps the compiler from moving the value copy across counter accesses */
+#define topic_barrier()		__asm__ __volatile__("" : : : "memory")
+
+#define topic_generation(seq)	((seq) >> 1)
+
+void topic_init(topic_t *tp, void *storage, unsigned int size) {
+	tp->seq = 0;
+	tp->data = storage;
+	tp->size = size;
+	wait_queue_init(&tp->subscribers);
+}
+
+void topic_publish(topic_t *tp, const void *value) {
+	irq_lock();
+
+	/* odd counter marks the value as torn for any subscriber that is mid-copy */
+	tp->seq++;
+	topic_barrier();
+
+	memcpy(tp->data, value, tp->size);
+
+	topic_barrier();
+	tp->seq++;
+
+	/* every subscriber wants the new value, so wake them all */
+	thread_impl_t *subscriber;
+	while ((subscriber = wait_queue_peek(&tp->subscribers)) != NULL) {
+		sched_impl_wake(subscriber, WAKE_SIGNALLED);
+	}
+
+	irq_unlock();
+}
+
+unsigned int topic_read(topic_t *tp, void *dst) {
+	unsigned int before, after;
+
+	/* retry only when a publish (from an ISR) overlapped the copy */
+	do {
+		before = tp->seq;
+		topic_barrier();
+
+		memcpy(dst, tp->data, tp->size);
+
+		topic_barrier();
+		after = tp->seq;
+	} while ((before & 1) || before != after);
+
+	return topic_generation(before);
+}
+
+bool topic_timedwait(topic_t *tp, unsigned int *gen, void *dst, unsigned int ms) {
+	bool fresh = true;
+
+	irq_lock();
+
+	if (topic_generation(tp->seq) == *gen) {
+		fresh = (arch_wait_for(&tp->subscribers, STATUS_TOPIC_BLOCKED, ms) == WAKE_SIGNALLED);
+	}
+
+	irq_unlock();
+
+	if (fresh) *gen = topic_read(tp, dst);
+
+	return fresh;
+}
+
+void topic_wait(topic_t *tp, unsigned int *gen, void *dst) {
+	topic_timedwait(tp, gen, dst, SCHED_WAIT_FOREVER);
+}
@@ -5,6 +5,8 @@
  *      Author: krad2
  */
 
+#include <limits.h>
+
 #include "rbtree.h"
 
 /**
@@ -298,6 +300,12 @@ void rbtree_lrcached_init(rbtree_lrcached *tree) {
 	rb_last_cached(tree) = NULL;
 }
 
+void rbtree_threaded_init(rbtree_threaded *tree) {
+	rbtree_init(&tree->tree);
+	rb_first_cached(tree) = NULL;
+	rb_last_cached(tree) = NULL;
+}
+
 static inline void __rb_node_clear(rbnode *node) {
 	if (!node) return;
 
@@ -310,6 +318,43 @@ void rbnode_init(rbnode *node) {
 	__rb_node_clear(node);
 }
 
+void rbtnode_init(rbtnode *node) {
+	if (!node) return;
+
+	__rb_node_clear(&node->node);
+	node->prev = NULL;
+	node->next = NULL;
+}
+
+/**
+ *	Helpers to splice threaded nodes in and out of the in-order thread.
+ */
+
+static inline void __rb_thread_link(rbtree_threaded *root, rbnode *node, rbnode *prev, rbnode *next) {
+    rb_threaded_prev(node) = prev;
+    rb_threaded_next(node) = next;
+
+    if (prev) rb_threaded_next(prev) = node;
+    else rb_first_cached(root) = node;
+
+    if (next) rb_threaded_prev(next) = node;
+    else rb_last_cached(root) = node;
+}
+
+static inline void __rb_thread_unlink(rbtree_threaded *root, rbnode *node) {
+    rbnode *prev = rb_threaded_prev(node);
+    rbnode *next = rb_threaded_next(node);
+
+    if (prev) rb_threaded_next(prev) = next;
+    else rb_first_cached(root) = next;
+
+    if (next) rb_threaded_prev(next) = prev;
+    else rb_last_cached(root) = prev;
+
+    rb_threaded_prev(node) = NULL;
+    rb_threaded_next(node) = NULL;
+}
+
 /**
  *	Red-black insertion given a comparator.
  */
@@ -397,6 +442,99 @@ void rb_lrcached_insert(rbtree_lrcached *root, rbnode *node,
     rb_insert(&root->tree, node, cmp);
 }
 
+void rb_threaded_insert(rbtree_threaded *root, rbnode *node,
+                       int (*cmp)(const void *left, const void *right)) {
+
+    rb_insert(&root->tree, node, cmp);
+
+    // rotations never change the sorted order, so one walk finds the predecessor and the thread gives the rest
+    rbnode *prev = (rbnode *) rb_prev(node);
+    rbnode *next = prev ? rb_threaded_next(prev) : rb_first_cached(root);
+
+    __rb_thread_link(root, node, prev, next);
+}
+
+/**
+ *	Linear-time construction from 'n' nodes already in ascending order, chained through their
+ *	right pointers. Splitting at the middle keeps every leaf within one level of the others, so
+ *	only the partially filled bottom level is colored red and every path has the same black height.
+ */
+
+static rbnode *__rb_build(rbnode **list, unsigned int n, unsigned int depth, unsigned int red_depth) {
+    if (n == 0) return NULL;
+
+    rbnode *left = __rb_build(list, n / 2, depth + 1, red_depth);
+
+    // the list head is the in-order successor of everything just built on the left
+    rbnode *node = *list;
+    *list = rb_right(node);
+
+    rb_left(node) = left;
+    rb_right(node) = __rb_build(list, n - (n / 2) - 1, depth + 1, red_depth);
+
+    __rb_set_parent(rb_left(node), node);
+    __rb_set_parent(rb_right(node), node);
+    __rb_set_color(node, (depth == red_depth) ? RB_RED : RB_BLACK);
+
+    return node;
+}
+
+void rb_build(rbtree *tree, rbnode *list, unsigned int n) {
+    if (!tree) return;
+
+    // the deepest level is full when n + 1 is a power of two, otherwise it holds the red nodes
+    unsigned int red_depth = UINT_MAX;
+    if ((n & (n + 1)) != 0) {
+        red_depth = 0;
+        while ((n >> (red_depth + 1)) != 0) red_depth++;
+    }
+
+    rb_root(tree) = __rb_build(&list, n, 0, red_depth);
+    __rb_set_parent_and_color(rb_root(tree), NULL, RB_BLACK);
+}
+
+void rb_lcached_build(rbtree_lcached *root, rbnode *list, unsigned int n) {
+    rb_first_cached(root) = list;
+    rb_build(&root->tree, list, n);
+}
+
+void rb_rcached_build(rbtree_rcached *root, rbnode *list, unsigned int n) {
+    rbnode *last = list;
+    for (unsigned int i = 1; i < n; ++i) last = rb_right(last);
+
+    rb_build(&root->tree, list, n);
+    rb_last_cached(root) = (n > 0) ? last : NULL;
+}
+
+void rb_lrcached_build(rbtree_lrcached *root, rbnode *list, unsigned int n) {
+    rbnode *last = list;
+    for (unsigned int i = 1; i < n; ++i) last = rb_right(last);
+
+    rb_first_cached(root) = (n > 0) ? list : NULL;
+    rb_build(&root->tree, list, n);
+    rb_last_cached(root) = (n > 0) ? last : NULL;
+}
+
+void rb_threaded_build(rbtree_threaded *root, rbnode *list, unsigned int n) {
+
+    // the list is already in order, so thread it before rb_build() reuses the right pointers
+    rbnode *prev = NULL;
+    rbnode *node = list;
+    for (unsigned int i = 0; i < n; ++i) {
+        rb_threaded_prev(node) = prev;
+        if (prev) rb_threaded_next(prev) = node;
+
+        prev = node;
+        node = rb_right(node);
+    }
+
+    if (prev) rb_threaded_next(prev) = NULL;
+
+    rb_first_cached(root) = (n > 0) ? list : NULL;
+    rb_last_cached(root) = prev;
+    rb_build(&root->tree, list, n);
+}
+
 /**
  *	Binary search to find 'key'. Returns NULL if not found.
  */
@@ -519,20 +657,46 @@ const rbnode *rb_prev(const rbnode *node) {
  * Basic BST deletion algorithm components - no balancing yet!
  */
 
-static inline const rbnode *__rb_node_successor(const rbnode *target) {
-	rbnode *successor;
+/**
+ * Exchanges the tree positions (and colors) of 'target' and its in-order successor.
+ * The nodes themselves are relinked rather than their keys copied, so containers stay attached to their own nodes.
+ */
+
+static inline void __rb_swap_with_successor(rbnode *target, rbnode *successor) {
+	rbnode *tparent = rb_parent(target);
+	rbnode *tleft = rb_left(target);
+	rbnode *tright = rb_right(target);
+	rbnode *sparent = rb_parent(successor);
+	rbnode *sright = rb_right(successor);	// the successor is leftmost in its subtree, so it has no left child
+
+	int tcolor = rb_color(target);
+	int scolor = rb_color(successor);
+
+	// the successor takes the target's place under the target's parent
+	if (tparent) {
+		if (rb_left(tparent) == target) rb_left(tparent) = successor;
+		else rb_right(tparent) = successor;
+	}
+	__rb_set_parent_and_color(successor, tparent, tcolor);
+
+	rb_left(successor) = tleft;
+	__rb_set_parent(tleft, successor);
 
-	if (rb_left(target) && rb_right(target)) {
-		successor = (rbnode *) rb_next(target);
-	} else if (!rb_right(target)) {
-		successor = rb_left(target);
-	} else if (!rb_left(target)) {
-		successor = rb_right(target);
+	// the target drops into the successor's old slot
+	if (sparent == target) {
+		rb_right(successor) = target;
+		__rb_set_parent_and_color(target, successor, scolor);
 	} else {
-		successor = NULL;
+		rb_right(successor) = tright;
+		__rb_set_parent(tright, successor);
+
+		rb_left(sparent) = target;
+		__rb_set_parent_and_color(target, sparent, scolor);
 	}
 
-    return successor;
+	rb_left(target) = NULL;
+	rb_right(target) = sright;
+	__rb_set_parent(sright, target);
 }
 
 /**
@@ -550,26 +714,6 @@ static inline void __rb_delete_node(rbnode *target) {
     __rb_node_clear(target);
 }
 
-/**
- * Basic copy-and-remove algorithm used by BST basic delete.
- */
-
-static inline void __rb_move_and_delete(rbnode *src, rbnode *dst,
-                                        void (*copy)(const void *src, void *dst)) {
-
-	if (src) {
-		copy((void *) src, (void *) dst);
-    	__rb_delete_node(src);
-	} else {
-		__rb_delete_node(dst);
-	}
-}
-
-static inline void __rb_delete_basic(rbnode *successor, rbnode *target,
-										void (*copy)(const void *src, void *dst)) {
-	__rb_move_and_delete(successor, target, copy);
-}
-
 /**
  * RB tree rebalancer.
  */
@@ -666,55 +810,64 @@ static inline void __rb_delete_rebalance(rbnode *node) {
 }
 
 /**
- * Deletes a node from the tree. Requires a comparator to find the element and a copy function to exchange elements.
+ * Deletes a node from the tree. The node itself is unlinked, so it must currently be in the tree.
+ * Keys are never exchanged between nodes, so no comparator or copy callback is needed.
  */
 
-void rb_delete(rbtree *tree, rbnode *node,
-               int (*cmp)(const void *left, const void *right),
-               void (*copy)(const void *src, void *dst)) {
+void rb_delete(rbtree *tree, rbnode *node) {
 
     if (!tree) return;
     if (!node) return;
-    if (!cmp) return;
-    if (!copy) return;
+    if (RB_EMPTY_NODE(node)) return;
 
-    rbnode *target, *successor, *cursor;
+    rbnode *parent, *child, *cursor;
 
-    target = (rbnode *) rb_find(tree, node, cmp);       // try to find the node to even delete, if it exists
-    if (!target) return;
+	// a node with 2 children trades places with its successor, leaving it with at most 1 child
+	if (rb_left(node) && rb_right(node)) {
+		__rb_swap_with_successor(node, (rbnode *) __rb_first(rb_right(node)));
+	}
 
-    successor = (rbnode *) __rb_node_successor(target);
-	if (successor) __rb_delete_rebalance(successor);	
-	else __rb_delete_rebalance(target);
-	
-	// follow the tree up to retrace root if it changed
-    cursor = target;
-	while (rb_parent(cursor) != NULL) {
-        cursor = rb_parent(cursor);
-    }
+	child = rb_left(node) ? rb_left(node) : rb_right(node);
+	parent = rb_parent(node);
 
-	// actually delete the node now
-	__rb_delete_basic(successor, target, copy);
+	if (child) {
 
-	// post-deletion check to see if tree has been cleared
-    if (RB_EMPTY_NODE(rb_root(tree))) {                             
-        rb_root(tree) = NULL;
-    } else {
-		rb_root(tree) = cursor;
+		// a lone child must be red under a black node, so it just absorbs the black
+		if (parent) {
+			if (rb_left(parent) == node) rb_left(parent) = child;
+			else rb_right(parent) = child;
+		}
+		__rb_set_parent_and_color(child, parent, RB_BLACK);
+		cursor = child;
+	} else {
+
+		// leaves are rebalanced in place, then cut off
+		__rb_delete_rebalance(node);
+
+		parent = rb_parent(node);
+		if (parent) {
+			if (rb_left(parent) == node) rb_left(parent) = NULL;
+			else rb_right(parent) = NULL;
+		}
+		cursor = parent;
+	}
+
+	__rb_node_clear(node);
+
+	// follow the tree up to retrace root if it changed
+	while (cursor != NULL && rb_parent(cursor) != NULL) {
+		cursor = rb_parent(cursor);
 	}
+
+	rb_root(tree) = cursor;
 }
 
-void rb_lcached_delete(rbtree_lcached *root, rbnode *node,
-                       int (*cmp)(const void *left, const void *right),
-                       void (*copy)(const void *src, void *dst)) {
+void rb_lcached_delete(rbtree_lcached *root, rbnode *node) {
 
     // deleting the min makes the new min the next element in sorted order
-    uint8_t min_changed = 0;
-    if (cmp((void *) node, (void *) rb_first_cached(root)) == 0) {
-        min_changed = 1;
-    }
+    uint8_t min_changed = (node == rb_first_cached(root));
 
-    rb_delete(&root->tree, node, cmp, copy);
+    rb_delete(&root->tree, node);
 
     // if the tree was emptied, we don't have a min
     if (RB_NULL_ROOT(&(root->tree))) {
@@ -724,17 +877,12 @@ void rb_lcached_delete(rbtree_lcached *root, rbnode *node,
     }
 }
 
-void rb_rcached_delete(rbtree_rcached *root, rbnode *node,
-                       int (*cmp)(const void *left, const void *right),
-                       void (*copy)(const void *src, void *dst)) {
+void rb_rcached_delete(rbtree_rcached *root, rbnode *node) {
 
     // deleting the max makes the new max the previous element in sorted order
-    uint8_t max_changed = 0;
-    if (cmp((void *) node, (void *) rb_last_cached(root)) == 0) {
-        max_changed = 1;
-    }
+    uint8_t max_changed = (node == rb_last_cached(root));
 
-    rb_delete(&root->tree, node, cmp, copy);
+    rb_delete(&root->tree, node);
 
     // if the tree was emptied, we don't have a max
     if (RB_NULL_ROOT(&root->tree)) {
@@ -744,23 +892,15 @@ void rb_rcached_delete(rbtree_rcached *root, rbnode *node,
     }
 }
 
-void rb_lrcached_delete(rbtree_lrcached *root, rbnode *node,
-                       int (*cmp)(const void *left, const void *right),
-                       void (*copy)(const void *src, void *dst)) {
+void rb_lrcached_delete(rbtree_lrcached *root, rbnode *node) {
 
     // deleting the min makes the new min the next element in sorted order
-    uint8_t min_changed = 0;
-    if (cmp((void *) node, (void *) rb_first_cached(root)) == 0) {
-        min_changed = 1;
-    }
+    uint8_t min_changed = (node == rb_first_cached(root));
 
     // deleting the max makes the new max the previous element in sorted order
-    uint8_t max_changed = 0;
-    if (cmp((void *) node, (void *) rb_last_cached(root)) == 0) {
-        max_changed = 1;
-    }
+    uint8_t max_changed = (node == rb_last_cached(root));
 
-    rb_delete(&root->tree, node, cmp, copy);
+    rb_delete(&root->tree, node);
 
     // deleting the whole tree deletes the max and min
     if (RB_NULL_ROOT(&root->tree)) {
@@ -773,6 +913,16 @@ void rb_lrcached_delete(rbtree_lrcached *root, rbnode *node,
     }
 }
 
+void rb_threaded_delete(rbtree_threaded *root, rbnode *node) {
+
+    if (!node) return;
+    if (RB_EMPTY_NODE(node)) return;
+
+    // nodes are relinked rather than their keys swapped, so the rest of the thread is unaffected
+    __rb_thread_unlink(root, node);
+    rb_delete(&root->tree, node);
+}
+
 void rbtree_clean(rbtree *tree) {
 	rb_inorder_foreach(tree, __rb_delete_node);
 }
@@ -793,6 +943,19 @@ void rb_lrcached_clean(rbtree_lrcached *tree) {
 	rb_last_cached(tree) = NULL;
 }
 
+void rb_threaded_clean(rbtree_threaded *tree) {
+	rbnode *node = rb_first_cached(tree);
+	while (node != NULL) {
+		rbnode *next = rb_threaded_next(node);
+		rbtnode_init(rb_thread(node));
+		node = next;
+	}
+
+	rbtree_init(&tree->tree);
+	rb_first_cached(tree) = NULL;
+	rb_last_cached(tree) = NULL;
+}
+
 /**
  * Tree traversal in all 3 'styles'. Invokes 'cb' on each node.
  */
@@ -832,3 +995,16 @@ void rb_postorder_foreach(rbtree *tree, void (*cb)(void *key)) {
 void rb_preorder_foreach(rbtree *tree, void (*cb)(void *key)) {
     __rb_preorder_foreach(rb_root(tree), cb);
 }
+
+/**
+ * In-order traversal along the thread. No recursion, and 'cb' may unlink the node it is given.
+ */
+
+void rb_threaded_foreach(rbtree_threaded *tree, void (*cb)(void *key)) {
+    rbnode *node = rb_first_cached(tree);
+    while (node != NULL) {
+        rbnode *next = rb_threaded_next(node);
+        cb(node);
+        node = next;
+    }
+}
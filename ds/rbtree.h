@@ -50,9 +50,32 @@ typedef struct __rbtree_lrcached {
     rbnode *rightmost; 	// logical max cached
 } rbtree_lrcached;
 
+/**
+ *	'Threaded' red-black tree definitions. Every node also links to its in-order neighbors,
+ *	so stepping through the tree is O(1) per step at the cost of two words per node.
+ *	Both ends of the thread are the tree's min and max, so they are cached for free.
+ */
+
+typedef struct __rbtnode {
+    rbnode node;		// must stay first, so the thread's NULL ends cast cleanly
+    rbnode *prev;		// in-order predecessor, NULL for the min
+    rbnode *next;		// in-order successor, NULL for the max
+} rbtnode;
+
+typedef struct __rbtree_threaded {
+    rbtree tree;
+
+    rbnode *leftmost;	// head of the thread
+    rbnode *rightmost;	// tail of the thread
+} rbtree_threaded;
+
 #define rb_first_cached(root)   (root)->leftmost
 #define rb_last_cached(root)    (root)->rightmost
 
+#define rb_thread(rb)           container_of((rb), rbtnode, node)
+#define rb_threaded_next(rb)    (rb_thread(rb)->next)
+#define rb_threaded_prev(rb)    (rb_thread(rb)->prev)
+
 /**
  * Helper macros to get properties of a node
  */
@@ -102,30 +125,37 @@ typedef struct __rbtree_lrcached {
  */
 
 void rbnode_init(rbnode *node);
+void rbtnode_init(rbtnode *node);
 
 void rbtree_init(rbtree *root);
 void rbtree_lcached_init(rbtree_lcached *root);
 void rbtree_rcached_init(rbtree_rcached *root);
 void rbtree_lrcached_init(rbtree_lrcached *root);
+void rbtree_threaded_init(rbtree_threaded *root);
 
 void rb_insert(rbtree *root, rbnode *node, int (*cmp)(const void *left, const void *right));
 void rb_lcached_insert(rbtree_lcached *root, rbnode *node, int (*cmp)(const void *left, const void *right));
 void rb_rcached_insert(rbtree_rcached *root, rbnode *node, int (*cmp)(const void *left, const void *right));
 void rb_lrcached_insert(rbtree_lrcached *root, rbnode *node, int (*cmp)(const void *left, const void *right));
+void rb_threaded_insert(rbtree_threaded *root, rbnode *node, int (*cmp)(const void *left, const void *right));
+
+void rb_build(rbtree *tree, rbnode *list, unsigned int n);
+void rb_lcached_build(rbtree_lcached *root, rbnode *list, unsigned int n);
+void rb_rcached_build(rbtree_rcached *root, rbnode *list, unsigned int n);
+void rb_lrcached_build(rbtree_lrcached *root, rbnode *list, unsigned int n);
+void rb_threaded_build(rbtree_threaded *root, rbnode *list, unsigned int n);
 
-void rb_delete(rbtree *tree, rbnode *node,
-               int (*cmp)(const void *left, const void *right), void (*copy)(const void *src, void *dst));
-void rb_lcached_delete(rbtree_lcached *tree, rbnode *node,
-               int (*cmp)(const void *left, const void *right), void (*copy)(const void *src, void *dst));
-void rb_rcached_delete(rbtree_rcached *tree, rbnode *node,
-               int (*cmp)(const void *left, const void *right), void (*copy)(const void *src, void *dst));
-void rb_lrcached_delete(rbtree_lrcached *tree, rbnode *node,
-               int (*cmp)(const void *left, const void *right), void (*copy)(const void *src, void *dst));
+void rb_delete(rbtree *tree, rbnode *node);
+void rb_lcached_delete(rbtree_lcached *tree, rbnode *node);
+void rb_rcached_delete(rbtree_rcached *tree, rbnode *node);
+void rb_lrcached_delete(rbtree_lrcached *tree, rbnode *node);
+void rb_threaded_delete(rbtree_threaded *tree, rbnode *node);
 
 void rbtree_clean(rbtree *tree);
 void rb_lcached_clean(rbtree_lcached *tree);
 void rb_rcached_clean(rbtree_rcached *tree);
 void rb_lrcached_clean(rbtree_lrcached *tree);
+void rb_threaded_clean(rbtree_threaded *tree);
 
 const rbnode *rb_find(const rbtree *root, const void *key, int (*cmp)(const void *left, const void *right));
 
@@ -138,6 +168,7 @@ const rbnode *rb_prev(const rbnode *node);
 void rb_inorder_foreach(rbtree *tree, void (*cb)(void *key));
 void rb_postorder_foreach(rbtree *tree, void (*cb)(void *key));
 void rb_preorder_foreach(rbtree *tree, void (*cb)(void *key));
+void rb_threaded_foreach(rbtree_threaded *tree, void (*cb)(void *key));
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,136 @@
+/*
+ * ringbuf.c
+ *
+ *  Created on: Jul 10, 2020
+ *      Author: krad2
+ */
+
+#include <string.h>
+
+#include "ringbuf.h"
+
+#ifndef min
+#define min(a,b) \
+  ({ __typeof__ (a) _a = (a); \
+      __typeof__ (b) _b = (b); \
+    _a < _b ? _a : _b; })
+#endif
+
+#define __ringbuf_slot(rb, idx)    ((rb)->buf + (((idx) & (rb)->mask) * (rb)->elem_size))
+
+/**
+ *	Sets a ring buffer up over caller-provided storage. 'size' must be a power of two.
+ */
+
+void ringbuf_init(ringbuf *rb, void *storage, unsigned int elem_size, unsigned int size) {
+    if (!rb) return;
+
+    rb->head = 0;
+    rb->tail = 0;
+    rb->mask = size - 1;
+    rb->elem_size = elem_size;
+    rb->buf = (uint8_t *) storage;
+}
+
+/**
+ *	Producer side. Only the producer may call these.
+ */
+
+bool ringbuf_push(ringbuf *rb, const void *elem) {
+    if (ringbuf_full(rb)) return false;
+
+    memcpy(__ringbuf_slot(rb, rb->head), elem, rb->elem_size);
+
+    // the element must be in place before the consumer can see the new head
+    ringbuf_barrier();
+    rb->head++;
+
+    return true;
+}
+
+void *ringbuf_write_span(ringbuf *rb, unsigned int *len) {
+    unsigned int head = rb->head;
+    unsigned int to_end = ringbuf_capacity(rb) - (head & rb->mask);
+
+    // the free region may wrap, only the part up to the end of storage is contiguous
+    *len = min(ringbuf_space(rb), to_end);
+    return __ringbuf_slot(rb, head);
+}
+
+void ringbuf_write_commit(ringbuf *rb, unsigned int n) {
+    ringbuf_barrier();
+    rb->head += n;
+}
+
+unsigned int ringbuf_push_bulk(ringbuf *rb, const void *src, unsigned int n) {
+    const uint8_t *cursor = (const uint8_t *) src;
+    unsigned int done = 0;
+
+    // at most 2 spans: up to the end of storage, then from the start
+    while (done < n) {
+        unsigned int len;
+        void *span = ringbuf_write_span(rb, &len);
+        if (len == 0) break;
+
+        len = min(len, n - done);
+        memcpy(span, cursor, len * rb->elem_size);
+        ringbuf_write_commit(rb, len);
+
+        cursor += len * rb->elem_size;
+        done += len;
+    }
+
+    return done;
+}
+
+/**
+ *	Consumer side. Only the consumer may call these.
+ */
+
+bool ringbuf_pop(ringbuf *rb, void *elem) {
+    if (ringbuf_empty(rb)) return false;
+
+    memcpy(elem, __ringbuf_slot(rb, rb->tail), rb->elem_size);
+
+    // the element must be copied out before the producer can reuse the slot
+    ringbuf_barrier();
+    rb->tail++;
+
+    return true;
+}
+
+const void *ringbuf_read_span(ringbuf *rb, unsigned int *len) {
+    unsigned int tail = rb->tail;
+    unsigned int to_end = ringbuf_capacity(rb) - (tail & rb->mask);
+
+    *len = min(ringbuf_count(rb), to_end);
+
+    // don't let reads of the span be hoisted above the head load
+    ringbuf_barrier();
+    return __ringbuf_slot(rb, tail);
+}
+
+void ringbuf_read_release(ringbuf *rb, unsigned int n) {
+    ringbuf_barrier();
+    rb->tail += n;
+}
+
+unsigned int ringbuf_pop_bulk(ringbuf *rb, void *dst, unsigned int n) {
+    uint8_t *cursor = (uint8_t *) dst;
+    unsigned int done = 0;
+
+    while (done < n) {
+        unsigned int len;
+        const void *span = ringbuf_read_span(rb, &len);
+        if (len == 0) break;
+
+        len = min(len, n - done);
+        memcpy(cursor, span, len * rb->elem_size);
+        ringbuf_read_release(rb, len);
+
+        cursor += len * rb->elem_size;
+        done += len;
+    }
+
+    return done;
+}
@@ -0,0 +1,97 @@
+/*
+ * ringbuf.h
+ *
+ *  Created on: Jul 10, 2020
+ *      Author: krad2
+ */
+
+#ifndef RINGBUF_H_
+#define RINGBUF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "port_config.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *	Lock-free single-producer / single-consumer ring buffer.
+ *
+ *	The producer only ever writes 'head' and the consumer only ever writes 'tail'. Both are
+ *	free-running word-sized counters, so each side publishes its progress with a single
+ *	atomic store and no critical section is needed between an ISR producer and a thread
+ *	consumer (or the other way around). The capacity must be a power of two so that
+ *	indices wrap with a mask and 'head - tail' is the fill level even across overflow.
+ */
+
+typedef struct __ringbuf {
+    volatile unsigned int head;		// total elements ever pushed, written by the producer only
+    volatile unsigned int tail;		// total elements ever popped, written by the consumer only
+
+    unsigned int mask;				// capacity - 1
+    unsigned int elem_size;			// bytes per element
+    uint8_t *buf;
+} ringbuf;
+
+/**
+ *	Declares a ring buffer and its storage. 'size' is a compile-time power of two.
+ */
+
+#define RINGBUF_DECLARE(name, type, size)                                               \
+    _Static_assert((size) > 0 && ((size) & ((size) - 1)) == 0,                          \
+                   "ringbuf size must be a power of two");                              \
+    static type __##name##_storage[(size)];                                             \
+    ringbuf name = { 0, 0, (size) - 1, sizeof(type), (uint8_t *) __##name##_storage }
+
+/**
+ *	Keeps the compiler from moving element accesses across index updates.
+ *	MSP430 is single core and in-order, so no hardware fence is needed.
+ */
+
+#define ringbuf_barrier()   __asm__ __volatile__("" : : : "memory")
+
+/**
+ *	API
+ */
+
+void ringbuf_init(ringbuf *rb, void *storage, unsigned int elem_size, unsigned int size);
+
+static inline unsigned int ringbuf_capacity(const ringbuf *rb) {
+    return rb->mask + 1;
+}
+
+static inline unsigned int ringbuf_count(const ringbuf *rb) {
+    return rb->head - rb->tail;
+}
+
+static inline unsigned int ringbuf_space(const ringbuf *rb) {
+    return ringbuf_capacity(rb) - ringbuf_count(rb);
+}
+
+static inline bool ringbuf_empty(const ringbuf *rb) {
+    return rb->head == rb->tail;
+}
+
+static inline bool ringbuf_full(const ringbuf *rb) {
+    return ringbuf_count(rb) == ringbuf_capacity(rb);
+}
+
+/* producer side */
+bool ringbuf_push(ringbuf *rb, const void *elem);
+unsigned int ringbuf_push_bulk(ringbuf *rb, const void *src, unsigned int n);
+void *ringbuf_write_span(ringbuf *rb, unsigned int *len);
+void ringbuf_write_commit(ringbuf *rb, unsigned int n);
+
+/* consumer side */
+bool ringbuf_pop(ringbuf *rb, void *elem);
+unsigned int ringbuf_pop_bulk(ringbuf *rb, void *dst, unsigned int n);
+const void *ringbuf_read_span(ringbuf *rb, unsigned int *len);
+void ringbuf_read_release(ringbuf *rb, unsigned int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RINGBUF_H_ */
@@ -0,0 +1,261 @@
+/*
+ * tlsf.c
+ *
+ *  Created on: Jul 19, 2020
+ *      Author: krad2
+ */
+
+#include <limits.h>
+
+#include "tlsf.h"
+
+#define TLSF_BLOCK_FREE             ((size_t) 1)
+#define TLSF_BLOCK_MIN              (2 * sizeof(tlsf_block *))          // room for the free list links
+#define TLSF_BLOCK_MAX              (((size_t) 1 << TLSF_FL_INDEX_MAX) - TLSF_ALIGN)
+#define TLSF_SMALL_BLOCK            ((size_t) 1 << TLSF_FL_INDEX_SHIFT)
+
+_Static_assert((TLSF_ALIGN & (TLSF_ALIGN - 1)) == 0 && TLSF_ALIGN >= 4, "tlsf header size must be a power of two");
+_Static_assert(TLSF_FL_COUNT <= sizeof(unsigned int) * CHAR_BIT, "tlsf first-level bitmap too narrow");
+_Static_assert(TLSF_SL_COUNT <= sizeof(unsigned int) * CHAR_BIT, "tlsf second-level bitmap too narrow");
+
+#define __tlsf_align_up(x)          (((x) + (TLSF_ALIGN - 1)) & ~(TLSF_ALIGN - 1))
+#define __tlsf_align_down(x)        ((x) & ~(TLSF_ALIGN - 1))
+
+#define __tlsf_size(b)              ((b)->size & ~TLSF_BLOCK_FREE)
+#define __tlsf_is_free(b)           (((b)->size & TLSF_BLOCK_FREE) != 0)
+#define __tlsf_payload(b)           ((void *) ((uint8_t *) (b) + TLSF_BLOCK_HEADER))
+#define __tlsf_from_payload(p)      ((tlsf_block *) ((uint8_t *) (p) - TLSF_BLOCK_HEADER))
+#define __tlsf_next_phys(b)         ((tlsf_block *) ((uint8_t *) __tlsf_payload(b) + __tlsf_size(b)))
+
+static inline int __tlsf_ffs(unsigned int word) {
+    return __builtin_ctz(word);
+}
+
+static inline int __tlsf_fls(unsigned int word) {
+    return (int) (sizeof(unsigned int) * CHAR_BIT) - 1 - __builtin_clz(word);
+}
+
+/**
+ *	Size to bin mapping. Small blocks share first-level class 0 and are binned linearly.
+ */
+
+static inline void __tlsf_mapping_insert(size_t size, int *fl, int *sl) {
+    if (size < TLSF_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (int) (size / (TLSF_SMALL_BLOCK / TLSF_SL_COUNT));
+    } else {
+        int f = __tlsf_fls((unsigned int) size);
+        *sl = (int) ((size >> (f - TLSF_SL_INDEX_COUNT_LOG2)) ^ TLSF_SL_COUNT);
+        *fl = f - (TLSF_FL_INDEX_SHIFT - 1);
+    }
+}
+
+/**
+ *	Rounds a request up to the next bin boundary so any block in the bin found is large enough.
+ */
+
+static inline void __tlsf_mapping_search(size_t size, int *fl, int *sl) {
+    if (size >= TLSF_SMALL_BLOCK) {
+        size += ((size_t) 1 << (__tlsf_fls((unsigned int) size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+
+    __tlsf_mapping_insert(size, fl, sl);
+}
+
+static tlsf_block *__tlsf_find_suitable(tlsf *t, int *fl, int *sl) {
+    unsigned int sl_map = t->sl_bitmap[*fl] & (~0U << *sl);
+
+    if (!sl_map) {
+        // nothing in this class, move up to the smallest non-empty larger class
+        unsigned int fl_map = (*fl + 1 < TLSF_FL_COUNT) ? (t->fl_bitmap & (~0U << (*fl + 1))) : 0;
+        if (!fl_map) return NULL;
+
+        *fl = __tlsf_ffs(fl_map);
+        sl_map = t->sl_bitmap[*fl];
+    }
+
+    *sl = __tlsf_ffs(sl_map);
+    return t->blocks[*fl][*sl];
+}
+
+static void __tlsf_remove_free(tlsf *t, tlsf_block *b, int fl, int sl) {
+    if (b->prev_free) b->prev_free->next_free = b->next_free;
+    if (b->next_free) b->next_free->prev_free = b->prev_free;
+
+    if (t->blocks[fl][sl] == b) {
+        t->blocks[fl][sl] = b->next_free;
+
+        if (!t->blocks[fl][sl]) {
+            t->sl_bitmap[fl] &= ~(1U << sl);
+            if (!t->sl_bitmap[fl]) t->fl_bitmap &= ~(1U << fl);
+        }
+    }
+}
+
+static void __tlsf_insert_free(tlsf *t, tlsf_block *b) {
+    int fl, sl;
+    __tlsf_mapping_insert(__tlsf_size(b), &fl, &sl);
+
+    b->prev_free = NULL;
+    b->next_free = t->blocks[fl][sl];
+    if (b->next_free) b->next_free->prev_free = b;
+
+    t->blocks[fl][sl] = b;
+    t->fl_bitmap |= 1U << fl;
+    t->sl_bitmap[fl] |= 1U << sl;
+}
+
+static inline void __tlsf_unlink(tlsf *t, tlsf_block *b) {
+    int fl, sl;
+    __tlsf_mapping_insert(__tlsf_size(b), &fl, &sl);
+    __tlsf_remove_free(t, b, fl, sl);
+}
+
+/**
+ *	Folds 'next' into 'b'. Both must be physically adjacent and off the free lists.
+ */
+
+static inline void __tlsf_absorb(tlsf_block *b, tlsf_block *next) {
+    b->size += TLSF_BLOCK_HEADER + __tlsf_size(next);
+    __tlsf_next_phys(b)->prev_phys = b;
+}
+
+/**
+ *	Sets a heap up over the given memory. Returns -1 if it's too small or too large to manage.
+ */
+
+int tlsf_init(tlsf *t, void *mem, size_t bytes) {
+    if (!t || !mem) return -1;
+
+    for (int i = 0; i < TLSF_FL_COUNT; ++i) {
+        t->sl_bitmap[i] = 0;
+        for (int j = 0; j < (int) TLSF_SL_COUNT; ++j) {
+            t->blocks[i][j] = NULL;
+        }
+    }
+
+    t->fl_bitmap = 0;
+
+    // payloads sit right after a header, so start the first header one header short of an aligned address
+    uintptr_t start = __tlsf_align_up((uintptr_t) mem + TLSF_BLOCK_HEADER) - TLSF_BLOCK_HEADER;
+    uintptr_t end = (uintptr_t) mem + bytes;
+    if (end < start + 2 * TLSF_BLOCK_HEADER + TLSF_BLOCK_MIN) return -1;
+
+    // one header for the block and one for the sentinel that ends the heap
+    size_t size = __tlsf_align_down(end - start - 2 * TLSF_BLOCK_HEADER);
+    if (size > TLSF_BLOCK_MAX) return -1;
+
+    tlsf_block *b = (tlsf_block *) start;
+    b->prev_phys = NULL;
+    b->size = size;
+
+    // the sentinel looks like a used zero-size block, so nothing ever merges past it
+    tlsf_block *sentinel = __tlsf_next_phys(b);
+    sentinel->prev_phys = b;
+    sentinel->size = 0;
+
+    b->size |= TLSF_BLOCK_FREE;
+    __tlsf_insert_free(t, b);
+
+    t->total = size;
+    t->used = 0;
+    t->peak = 0;
+
+    return 0;
+}
+
+void *tlsf_malloc(tlsf *t, size_t size) {
+    if (size == 0 || size > TLSF_BLOCK_MAX) return NULL;
+
+    size = __tlsf_align_up(size);
+    if (size < TLSF_BLOCK_MIN) size = TLSF_BLOCK_MIN;
+
+    int fl, sl;
+    __tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT) return NULL;
+
+    tlsf_block *b = __tlsf_find_suitable(t, &fl, &sl);
+    if (!b) return NULL;
+
+    __tlsf_remove_free(t, b, fl, sl);
+    b->size &= ~TLSF_BLOCK_FREE;
+
+    // split off the tail if it can hold a block of its own
+    if (__tlsf_size(b) >= size + TLSF_BLOCK_HEADER + TLSF_BLOCK_MIN) {
+        tlsf_block *rem = (tlsf_block *) ((uint8_t *) __tlsf_payload(b) + size);
+
+        rem->prev_phys = b;
+        rem->size = (__tlsf_size(b) - size - TLSF_BLOCK_HEADER) | TLSF_BLOCK_FREE;
+        __tlsf_next_phys(rem)->prev_phys = rem;
+
+        b->size = size;
+        __tlsf_insert_free(t, rem);
+    }
+
+    t->used += __tlsf_size(b);
+    if (t->used > t->peak) t->peak = t->used;
+
+    return __tlsf_payload(b);
+}
+
+void tlsf_free(tlsf *t, void *ptr) {
+    if (!ptr) return;
+
+    tlsf_block *b = __tlsf_from_payload(ptr);
+    t->used -= __tlsf_size(b);
+
+    // coalesce with free physical neighbours so adjacent holes never coexist
+    tlsf_block *prev = b->prev_phys;
+    if (prev && __tlsf_is_free(prev)) {
+        __tlsf_unlink(t, prev);
+        prev->size &= ~TLSF_BLOCK_FREE;
+        __tlsf_absorb(prev, b);
+        b = prev;
+    }
+
+    tlsf_block *next = __tlsf_next_phys(b);
+    if (__tlsf_is_free(next)) {
+        __tlsf_unlink(t, next);
+        next->size &= ~TLSF_BLOCK_FREE;
+        __tlsf_absorb(b, next);
+    }
+
+    b->size |= TLSF_BLOCK_FREE;
+    __tlsf_insert_free(t, b);
+}
+
+/**
+ *	Usable bytes of an allocated block, which can be more than requested.
+ */
+
+size_t tlsf_block_size(void *ptr) {
+    return ptr ? __tlsf_size(__tlsf_from_payload(ptr)) : 0;
+}
+
+/**
+ *	Not constant time: walks every free list to total the free space and find the largest block.
+ */
+
+void tlsf_get_stats(tlsf *t, tlsf_stats *stats) {
+    stats->total = t->total;
+    stats->used = t->used;
+    stats->peak = t->peak;
+
+    // headers freed by merging become payload, so 'total - used' would undercount
+    stats->free = 0;
+    stats->largest_free = 0;
+
+    for (int fl = 0; fl < TLSF_FL_COUNT; ++fl) {
+        for (int sl = 0; sl < (int) TLSF_SL_COUNT; ++sl) {
+            for (tlsf_block *b = t->blocks[fl][sl]; b; b = b->next_free) {
+                size_t size = __tlsf_size(b);
+
+                stats->free += size;
+                if (size > stats->largest_free) stats->largest_free = size;
+            }
+        }
+    }
+
+    stats->fragmentation = stats->free ?
+            (unsigned int) (100 - ((uint32_t) stats->largest_free * 100) / stats->free) : 0;
+}
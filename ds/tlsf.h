@@ -0,0 +1,87 @@
+/*
+ * tlsf.h
+ *
+ *  Created on: Jul 19, 2020
+ *      Author: krad2
+ */
+
+#ifndef TLSF_H_
+#define TLSF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "port_config.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *	Two-level segregated fit allocator.
+ *
+ *	Free blocks are binned by size into power-of-two first-level classes, each split into
+ *	TLSF_SL_COUNT linear second-level classes. A bitmap per level records which bins are
+ *	non-empty, so finding a fitting block is a couple of bit scans and malloc/free run in
+ *	constant time regardless of how many blocks the heap holds. Freed blocks are merged with
+ *	their free physical neighbours immediately.
+ *
+ *	No locking is done here, see heap.h for the thread-safe wrapper.
+ */
+
+#define TLSF_SL_INDEX_COUNT_LOG2    3       // 8 second-level bins per size class
+#define TLSF_FL_INDEX_MAX           15      // blocks up to 32 KiB
+
+#define TLSF_SL_COUNT               (1U << TLSF_SL_INDEX_COUNT_LOG2)
+
+typedef struct __tlsf_block {
+    struct __tlsf_block *prev_phys;     // physically preceding block, NULL for the first one
+    size_t size;                        // payload bytes, bit 0 set while the block is free
+
+    // only valid while the block is free, they overlap the payload otherwise
+    struct __tlsf_block *next_free;
+    struct __tlsf_block *prev_free;
+} tlsf_block;
+
+/**
+ *	Every block payload is aligned to the header size, which leaves the low bits of 'size' for flags.
+ */
+
+#define TLSF_BLOCK_HEADER           offsetof(tlsf_block, next_free)
+#define TLSF_ALIGN                  TLSF_BLOCK_HEADER
+
+#define TLSF_FL_INDEX_SHIFT         (TLSF_SL_INDEX_COUNT_LOG2 + 2)
+#define TLSF_FL_COUNT               (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+typedef struct __tlsf {
+    unsigned int fl_bitmap;                             // non-empty first-level classes
+    unsigned int sl_bitmap[TLSF_FL_COUNT];              // non-empty second-level bins per class
+    tlsf_block *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];   // free list heads
+
+    size_t total;                                       // payload bytes managed
+    size_t used;                                        // payload bytes handed out
+    size_t peak;                                        // high-water mark of 'used'
+} tlsf;
+
+typedef struct __tlsf_stats {
+    size_t total;
+    size_t used;
+    size_t peak;
+    size_t free;
+    size_t largest_free;                // largest single allocation that would currently succeed
+    unsigned int fragmentation;         // percent of free memory outside the largest free block
+} tlsf_stats;
+
+/**
+ *	API
+ */
+
+int tlsf_init(tlsf *t, void *mem, size_t bytes);
+void *tlsf_malloc(tlsf *t, size_t size);
+void tlsf_free(tlsf *t, void *ptr);
+size_t tlsf_block_size(void *ptr);
+void tlsf_get_stats(tlsf *t, tlsf_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TLSF_H_ */
@@ -0,0 +1,95 @@
+/*
+ * ao.h
+ *
+ *  Created on: Jul 23, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_AO_H_
+#define INCLUDE_AO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ringbuf.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name Run-to-completion active objects.
+ * @details An active object owns an event queue and a handler that processes one event at a time and
+ * always returns. Every active object of an ao_kernel_t is dispatched on the stack of one host thread
+ * running ao_kernel_run(), which is an ordinary thread to the scheduler. Among themselves, active objects
+ * are scheduled by priority under a stack resource policy ceiling: a handler that posts to a higher
+ * priority object runs that object's handler right away, nested on the same stack, and lower priority
+ * work waits until every higher priority queue is drained. Posts from ISRs and other threads are picked
+ * up at the next handler boundary. No per-object stack or register context is ever saved.
+ * @{
+ */
+
+/**
+ * @brief Base of every event. Extend it by embedding it as the first member of a larger structure.
+ * @details Events are passed by pointer and must stay valid until their handler has returned.
+ */
+typedef struct ao_event {
+	unsigned int sig;
+} ao_event_t;
+
+typedef struct ao ao_t;
+typedef struct ao_kernel ao_kernel_t;
+
+/**
+ * @brief Event handler. Must not block; runs to completion on the host thread's stack.
+ */
+typedef void (*ao_handler_t)(ao_t *ao, const ao_event_t *evt);
+
+struct ao {
+	ao_handler_t handler;
+	ao_kernel_t *kernel;
+	unsigned int priority;			/* unique within the kernel, higher runs first */
+	ringbuf queue;					/* const ao_event_t * */
+	uint32_t dispatched;
+	uint32_t dropped;				/* posts refused because the queue was full */
+};
+
+struct ao_kernel {
+	ao_t *aos[CONFIG_AO_PRIORITIES];
+	volatile unsigned int ready;	/* one bit per priority with events queued */
+	unsigned int ceiling;			/* priority + 1 of the running handler, 0 between handlers */
+	thread_t *host;					/* thread running ao_kernel_run(), NULL until it starts */
+};
+
+void ao_kernel_init(ao_kernel_t *k);
+
+/**
+ * @brief Prepares an active object with a caller-provided event queue.
+ * @param[in] storage Room for 'len' event pointers. 'len' is a power of two.
+ */
+void ao_init(ao_t *ao, ao_handler_t handler, unsigned int priority, const ao_event_t **storage, unsigned int len);
+
+/**
+ * @brief Attaches an active object to a kernel. Panics if its priority is out of range or taken.
+ */
+void ao_start(ao_kernel_t *k, ao_t *ao);
+
+/**
+ * @brief Queues an event. Safe to call from ISRs, threads and handlers.
+ * @return False if the queue was full and the event was dropped.
+ */
+bool ao_post(ao_t *ao, const ao_event_t *evt);
+
+/**
+ * @brief Host thread runnable. Pass the ao_kernel_t as its argument. Never returns.
+ */
+int ao_kernel_run(void *arg);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_AO_H_ */
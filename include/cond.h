@@ -0,0 +1,62 @@
+/*
+ * cond.h
+ *
+ *  Created on: Jul 3, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_COND_H_
+#define INCLUDE_COND_H_
+
+#include "mutex.h"
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Condition variable bound to a kernel mutex.
+ */
+typedef struct cond {
+	wait_queue_t waiters;		/* threads in STATUS_COND_BLOCKED */
+	mutex_t *mtx;				/* mutex the current waiters released, all waiters must use the same one */
+} cond_t;
+
+/**
+ * @brief Prepares a condition variable with no waiters.
+ */
+void cond_init(cond_t *cond);
+
+/**
+ * @brief Atomically releases the mutex and blocks until signalled.
+ * @details The mutex is held again when this returns. Callers must recheck their predicate.
+ * @param[in] mtx Mutex held by the calling thread.
+ */
+void cond_wait(cond_t *cond, mutex_t *mtx);
+
+/**
+ * @brief Same as cond_wait(), but gives up after the given time.
+ * @details The mutex is held again when this returns, even on a timeout.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if signalled, false if the timeout expired first.
+ */
+bool cond_timedwait(cond_t *cond, mutex_t *mtx, unsigned int ms);
+
+/**
+ * @brief Wakes the oldest waiter, if any.
+ */
+void cond_signal(cond_t *cond);
+
+/**
+ * @brief Wakes all waiters.
+ * @details Waiters are moved onto the mutex wait queue instead of the run queue,
+ * so they are released one at a time as the mutex is handed over.
+ */
+void cond_broadcast(cond_t *cond);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_COND_H_ */
@@ -0,0 +1,174 @@
+/*
+ * coro.h
+ *
+ *  Created on: Jul 22, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_CORO_H_
+#define INCLUDE_CORO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sched.h"
+#include "sema.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name Stackless coroutines.
+ * @details A coroutine is a function that suspends by returning and resumes at the line it left off,
+ * protothread style. Its whole state is a coro_t, so any number of them can share the stack of the one
+ * host thread running coro_host_run(). Locals don't survive a suspension, so keep state in a structure
+ * around the coro_t and recover it with container_of(). Only one suspension macro may appear per line,
+ * and suspension macros can't be used inside a switch statement of the coroutine itself.
+ * @{
+ */
+
+typedef struct coro coro_t;
+
+/**
+ * @brief Coroutine body, bracketed by CORO_BEGIN() and CORO_END().
+ */
+typedef void (*coro_fn_t)(coro_t *co);
+
+/**
+ * @brief Scheduling state of a coroutine, as seen by its host.
+ */
+typedef enum {
+	CORO_READY,					/* runs on the next pass */
+	CORO_WAITING,				/* runs once its condition, object or timeout fires */
+	CORO_DONE					/* ran off CORO_END() or called CORO_EXIT(), dropped by the host */
+} coro_state_t;
+
+/**
+ * @brief Outcome of the last CORO_DELAY() or CORO_WAIT_OBJ().
+ */
+typedef enum {
+	CORO_OK,					/* the object was consumed */
+	CORO_TIMEOUT				/* the timeout expired first, always the case for CORO_DELAY() */
+} coro_result_t;
+
+struct coro {
+	coro_fn_t fn;
+	coro_t *next;				/* host's coroutine list */
+	wait_obj_t *wobj;			/* object being waited on, NULL if none */
+	unsigned int lc;			/* line to resume at, 0 before the first run */
+	unsigned int wake_time;		/* arch_time_now() deadline, if CORO_TIMED */
+	uint8_t state;				/* coro_state_t */
+	uint8_t flags;				/* CORO_TIMED, CORO_POLL */
+	uint8_t result;				/* coro_result_t */
+};
+
+#define CORO_TIMED										(1 << 0)	/* wake_time is armed */
+#define CORO_POLL										(1 << 1)	/* re-run every pass to re-check a condition */
+
+/**
+ * @brief Runs any number of coroutines on the stack of a single thread.
+ * @details Coroutines waiting on objects are folded into one sched_wait_any() call, so the host only
+ * wakes up when one of them can make progress, a timeout expires or coro_host_kick() is called.
+ * Waits that don't fit in CONFIG_WAIT_ANY_MAX, and CORO_WAIT_UNTIL() conditions, are re-checked
+ * every CONFIG_CORO_POLL_MS instead.
+ */
+typedef struct coro_host {
+	coro_t *coros;				/* owned by the host thread */
+	coro_t *added;				/* started since the last pass, handed over by coro_start() */
+	sema_t kick;
+} coro_host_t;
+
+/**
+ * @brief Prepares a coroutine to run from the top of its body.
+ */
+void coro_init(coro_t *co, coro_fn_t fn);
+
+void coro_host_init(coro_host_t *host);
+
+/**
+ * @brief Hands a coroutine to a host. It runs on the host's next pass. Safe to call from ISRs and coroutines.
+ */
+void coro_start(coro_host_t *host, coro_t *co);
+
+/**
+ * @brief Wakes the host so CORO_WAIT_UNTIL() conditions are re-checked right away. Safe to call from ISRs.
+ */
+void coro_host_kick(coro_host_t *host);
+
+/**
+ * @brief Host thread runnable. Pass the coro_host_t as its argument. Never returns.
+ */
+int coro_host_run(void *arg);
+
+/**
+ * @brief Arms a timeout and marks the coroutine waiting. Used by CORO_DELAY().
+ */
+void coro_arm_delay(coro_t *co, unsigned int ms);
+
+/**
+ * @brief Arms an object wait with an optional timeout and marks the coroutine waiting. Used by CORO_WAIT_OBJ().
+ */
+void coro_arm_wait(coro_t *co, wait_obj_t *wobj, unsigned int ms);
+
+/**
+ * @brief Starts a coroutine body.
+ */
+#define CORO_BEGIN(co)									switch ((co)->lc) { case 0:
+
+/**
+ * @brief Ends a coroutine body. Running off the end finishes the coroutine.
+ */
+#define CORO_END(co)									} (co)->lc = 0; (co)->state = CORO_DONE; return
+
+/**
+ * @brief Returns to the host, resuming right after this point on a later pass.
+ */
+#define CORO_SUSPEND(co)								do { (co)->lc = __LINE__; return; case __LINE__:; } while (0)
+
+/**
+ * @brief Lets every other ready coroutine run once before continuing.
+ */
+#define CORO_YIELD(co)									CORO_SUSPEND(co)
+
+/**
+ * @brief Finishes the coroutine from anywhere in its body.
+ */
+#define CORO_EXIT(co)									do { (co)->lc = 0; (co)->state = CORO_DONE; return; } while (0)
+
+/**
+ * @brief Suspends until the condition holds. The condition is polled, so kick the host when it changes.
+ */
+#define CORO_WAIT_UNTIL(co, cond)																		\
+	do {																								\
+		(co)->lc = __LINE__; case __LINE__:																\
+		if (!(cond)) {																					\
+			(co)->state = CORO_WAITING;																	\
+			(co)->flags = CORO_POLL;																	\
+			return;																						\
+		}																								\
+	} while (0)
+
+/**
+ * @brief Suspends for at least the given time.
+ */
+#define CORO_DELAY(co, ms)								do { coro_arm_delay((co), (ms)); CORO_SUSPEND(co); } while (0)
+
+/**
+ * @brief Suspends until the object can be consumed, as by sched_wait_any(), or the timeout expires.
+ * @details The wait_obj_t must outlive the wait. Check the outcome with CORO_TIMED_OUT().
+ */
+#define CORO_WAIT_OBJ(co, wobj, ms)						do { coro_arm_wait((co), (wobj), (ms)); CORO_SUSPEND(co); } while (0)
+
+/**
+ * @brief True if the last CORO_DELAY() or CORO_WAIT_OBJ() ended by timeout.
+ */
+#define CORO_TIMED_OUT(co)								((co)->result == CORO_TIMEOUT)
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_CORO_H_ */
@@ -0,0 +1,65 @@
+/*
+ * flags.h
+ *
+ *  Created on: Jul 6, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_FLAGS_H_
+#define INCLUDE_FLAGS_H_
+
+#include <stdbool.h>
+
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Group of event flags. Setting flags wakes every waiter whose condition is now met.
+ */
+typedef struct flags {
+	unsigned int bits;
+	wait_queue_t waiters;		/* threads in STATUS_FLAG_BLOCKED_ANY / _ALL or STATUS_MULTI_BLOCKED */
+} flags_t;
+
+/**
+ * @brief Prepares a flag group with every flag cleared.
+ */
+void flags_init(flags_t *flg);
+
+/**
+ * @brief Sets flags and wakes the waiters they satisfy. Safe to call from ISRs.
+ */
+void flags_set(flags_t *flg, unsigned int mask);
+
+/**
+ * @brief Clears flags. Safe to call from ISRs.
+ */
+void flags_clear(flags_t *flg, unsigned int mask);
+
+/**
+ * @brief Waits until any (or all) of the flags in 'mask' are set, blocking for at most the given time.
+ * @details Flags are not consumed, use flags_clear() to acknowledge them.
+ * @param[in] all True to wait for every flag in 'mask', false for any of them.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return Snapshot of the flags that satisfied the wait, or 0 if the timeout expired first.
+ */
+unsigned int flags_timedwait(flags_t *flg, unsigned int mask, bool all, unsigned int ms);
+
+/**
+ * @brief Waits until any of the flags in 'mask' are set.
+ */
+unsigned int flags_wait_any(flags_t *flg, unsigned int mask);
+
+/**
+ * @brief Waits until all of the flags in 'mask' are set.
+ */
+unsigned int flags_wait_all(flags_t *flg, unsigned int mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_FLAGS_H_ */
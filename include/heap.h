@@ -0,0 +1,83 @@
+/*
+ * heap.h
+ *
+ *  Created on: Jul 19, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_HEAP_H_
+#define INCLUDE_HEAP_H_
+
+#include <stddef.h>
+#include "port_config.h"
+#include "mutex.h"
+#include "tlsf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Thread-safe TLSF heap.
+ * @details Each heap is guarded by its own mutex, so interrupts are only masked for the few
+ * instructions it takes to acquire it and an allocation never delays an ISR. Threads contending
+ * for the same heap block on the mutex. Heaps can't be used from ISRs; use a pool_t there.
+ */
+typedef struct heap {
+	tlsf tlsf;
+	mutex_t lock;
+} heap_t;
+
+typedef tlsf_stats heap_stats_t;
+
+/**
+ * @name Generic heaps
+ * @{
+ */
+
+/**
+ * @brief Sets a heap up over the given memory.
+ * @return 0 on success, -1 if the region is too small or too large.
+ */
+int heap_init(heap_t *heap, void *mem, size_t size);
+
+/**
+ * @brief Allocates at least 'size' bytes in bounded time.
+ * @return The allocation, or NULL if no free block is large enough.
+ */
+void *heap_malloc(heap_t *heap, size_t size);
+
+/**
+ * @brief Releases an allocation, merging it with free neighbours. NULL is ignored.
+ */
+void heap_free(heap_t *heap, void *ptr);
+
+/**
+ * @brief Reads usage, peak usage and fragmentation. Walks the free lists, so keep it off hot paths.
+ */
+void heap_get_stats(heap_t *heap, heap_stats_t *stats);
+
+/** @} */
+
+#if (CONFIG_DYNAMIC_ALLOCATION == 1)
+
+/**
+ * @name System heap
+ * @brief A heap over a static buffer of CONFIG_DYNAMIC_HEAP_SIZE bytes.
+ * @{
+ */
+
+void heap_sys_init(void);
+void *heap_sys_malloc(size_t size);
+void heap_sys_free(void *ptr);
+void heap_sys_get_stats(heap_stats_t *stats);
+
+/** @} */
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_HEAP_H_ */
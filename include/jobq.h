@@ -0,0 +1,99 @@
+/*
+ * jobq.h
+ *
+ *  Created on: Jul 21, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_JOBQ_H_
+#define INCLUDE_JOBQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "rbtree.h"
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct job job_t;
+
+/**
+ * @brief Job body. Recover the surrounding structure with container_of() for per-job data.
+ */
+typedef void (*job_fn_t)(job_t *job);
+
+/**
+ * @brief Work item, embedded in caller-owned storage. A job can be resubmitted once it has started.
+ */
+struct job {
+	job_fn_t fn;
+	unsigned int priority;			/* higher runs first, equal priorities run in submission order */
+	unsigned int seq;				/* submission order within the queue */
+	unsigned int submit_time;		/* arch_time_now() at submission */
+	bool queued;
+
+	rbnode node;					/* job queue entry */
+};
+
+/**
+ * @brief Priority job queue served by a fixed set of worker threads.
+ * @details Times are in arch_time_now() cycles.
+ */
+typedef struct jobq {
+	rbtree_rcached jobs;			/* pending jobs, the highest priority cached */
+	unsigned int seq;
+	wait_queue_t idle;				/* workers with nothing to do, in STATUS_RECEIVE_BLOCKED */
+
+	unsigned int depth;				/* jobs waiting to start */
+	unsigned int depth_max;			/* high-water mark of depth */
+	uint32_t submitted;
+	uint32_t completed;
+	uint32_t latency_total;			/* submission to start, summed over started jobs */
+	unsigned int latency_max;
+	uint32_t run_total;				/* start to finish, summed over completed jobs */
+	unsigned int run_max;
+} jobq_t;
+
+/**
+ * @brief Marks a job as not queued. Needed once before the first submission unless the job is zero-initialized.
+ */
+void job_init(job_t *job);
+
+/**
+ * @brief Prepares an empty job queue.
+ */
+void jobq_init(jobq_t *q);
+
+/**
+ * @brief Worker thread runnable, takes the jobq_t as its argument.
+ * @details Use it with THREAD_DEFINE() or thread_init() for statically allocated workers.
+ */
+int jobq_worker(void *arg);
+
+/**
+ * @brief Creates 'n' workers with thread_create(), each with a stack of 'stack_size' bytes.
+ * @return Number of workers actually created.
+ */
+unsigned int jobq_spawn(jobq_t *q, unsigned int n, size_t stack_size, unsigned int shares);
+
+/**
+ * @brief Queues a job and wakes an idle worker. Safe to call from ISRs.
+ * @return False if the job is still waiting to start from an earlier submission.
+ */
+bool jobq_submit(jobq_t *q, job_t *job, job_fn_t fn, unsigned int priority);
+
+/**
+ * @brief Removes a job that hasn't started yet.
+ * @return True if the job was dequeued before running.
+ */
+bool jobq_cancel(jobq_t *q, job_t *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_JOBQ_H_ */
@@ -0,0 +1,67 @@
+/*
+ * mbox.h
+ *
+ *  Created on: Jul 6, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_MBOX_H_
+#define INCLUDE_MBOX_H_
+
+#include <stdbool.h>
+
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Mailbox of pointer-sized messages backed by a caller-provided ring of slots.
+ * @details A message posted while a receiver is waiting is written straight into the receiver's destination.
+ */
+typedef struct mbox {
+	void **slots;				/* ring storage */
+	unsigned int size;			/* number of slots */
+	unsigned int head;			/* slot holding the oldest message */
+	unsigned int count;			/* number of queued messages */
+	wait_queue_t receivers;		/* threads in STATUS_MBOX_BLOCKED or STATUS_MULTI_BLOCKED */
+} mbox_t;
+
+/**
+ * @brief Prepares an empty mailbox.
+ * @param[in] slots Storage for up to 'size' messages.
+ */
+void mbox_init(mbox_t *mbox, void **slots, unsigned int size);
+
+/**
+ * @brief Posts a message without blocking. Safe to call from ISRs.
+ * @return True if the message was delivered or queued, false if the mailbox is full.
+ */
+bool mbox_put(mbox_t *mbox, void *msg);
+
+/**
+ * @brief Receives the oldest message, blocking for at most the given time.
+ * @param[out] msg Where to store the message.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if a message was received, false if the timeout expired first.
+ */
+bool mbox_timedget(mbox_t *mbox, void **msg, unsigned int ms);
+
+/**
+ * @brief Receives the oldest message, blocking until one arrives.
+ */
+void *mbox_get(mbox_t *mbox);
+
+/**
+ * @brief Receives the oldest message only if one is queued.
+ * @param[out] msg Where to store the message.
+ * @return True if a message was received.
+ */
+bool mbox_tryget(mbox_t *mbox, void **msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_MBOX_H_ */
@@ -0,0 +1,61 @@
+/*
+ * mutex.h
+ *
+ *  Created on: Jul 3, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_MUTEX_H_
+#define INCLUDE_MUTEX_H_
+
+#include <stdbool.h>
+
+#include "thread.h"
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kernel mutex. Ownership is handed directly to the oldest waiter on unlock.
+ */
+typedef struct mutex {
+	volatile thread_t *owner;	/* NULL when the mutex is free */
+	wait_queue_t waiters;		/* threads in STATUS_MUTEX_BLOCKED */
+} mutex_t;
+
+/**
+ * @brief Prepares an unlocked mutex.
+ */
+void mutex_init(mutex_t *mtx);
+
+/**
+ * @brief Takes the mutex, blocking the calling thread until it is available.
+ */
+void mutex_lock(mutex_t *mtx);
+
+/**
+ * @brief Takes the mutex, blocking the calling thread for at most the given time.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if the mutex was taken, false if the timeout expired first.
+ */
+bool mutex_timedlock(mutex_t *mtx, unsigned int ms);
+
+/**
+ * @brief Takes the mutex only if it is free.
+ * @return True if the mutex was taken, false otherwise.
+ */
+bool mutex_trylock(mutex_t *mtx);
+
+/**
+ * @brief Releases the mutex. The oldest waiter, if any, becomes the new owner.
+ * @details Must be called by the owner.
+ */
+void mutex_unlock(mutex_t *mtx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_MUTEX_H_ */
@@ -0,0 +1,60 @@
+/*
+ * notify.h
+ *
+ *  Created on: Jul 8, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_NOTIFY_H_
+#define INCLUDE_NOTIFY_H_
+
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name Direct-to-task notifications.
+ * @details Every thread_t carries a notification word. Notifying a thread updates that word
+ * and, if the thread is blocked in notify_wait(), puts it straight back on the run queue.
+ * No wait queue or kernel object is involved, which makes this the cheapest wake path for
+ * one producer (typically an ISR) signalling one dedicated thread. All notify_* updates are ISR-safe.
+ * @{
+ */
+
+/**
+ * @brief ORs bits into the thread's notification word, e.g. to use it as a private flag group.
+ */
+void notify_set_bits(thread_t *thr, unsigned int bits);
+
+/**
+ * @brief Increments the thread's notification word, e.g. to use it as a private counting semaphore.
+ */
+void notify_increment(thread_t *thr);
+
+/**
+ * @brief Replaces the thread's notification word, e.g. to use it as a private mailbox.
+ */
+void notify_overwrite(thread_t *thr, unsigned int value);
+
+/**
+ * @brief Blocks the calling thread until its notification word is nonzero, for at most the given time.
+ * @details The word is read and cleared in one step.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return The notification word, or 0 if the timeout expired first.
+ */
+unsigned int notify_timedwait(unsigned int ms);
+
+/**
+ * @brief Blocks the calling thread until its notification word is nonzero, then reads and clears it.
+ */
+unsigned int notify_wait(void);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_NOTIFY_H_ */
@@ -0,0 +1,96 @@
+/*
+ * pbuf.h
+ *
+ *  Created on: Jul 15, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_PBUF_H_
+#define INCLUDE_PBUF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pbuf_pool pbuf_pool_t;
+
+/**
+ * @brief Reference-counted packet buffer block.
+ * @details Blocks chain through 'next' into packets. A reference to a packet is a reference to its
+ * first block, and dropping the last one releases the block and its share of the rest of the chain.
+ * Pass packets between threads and ISRs by pointer, e.g. through an mbox_t, and nothing is copied.
+ */
+typedef struct pbuf {
+	struct pbuf *next;				/* next block of the packet, or next free block in the pool */
+	pbuf_pool_t *pool;				/* pool the block returns to */
+	unsigned int refs;				/* references held on this block */
+	unsigned int len;				/* bytes of payload in use */
+	uint8_t payload[];				/* pool->payload_size bytes */
+} pbuf_t;
+
+/**
+ * @brief Fixed-size block pool. Blocks are carved from storage reserved at compile time.
+ */
+struct pbuf_pool {
+	pbuf_t *free;					/* singly linked free list */
+	unsigned int payload_size;		/* payload bytes per block */
+	unsigned int num_blocks;		/* blocks in the pool */
+	unsigned int num_free;			/* blocks currently on the free list */
+	uint8_t *storage;
+};
+
+/**
+ * @brief Bytes taken by one block, rounded up to keep every block header word-aligned.
+ */
+#define PBUF_BLOCK_SIZE(payload_size)	\
+	((sizeof(pbuf_t) + (payload_size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+/**
+ * @brief Reserves storage for a pool of 'num' blocks of 'payload_size' bytes. Call pbuf_pool_init() before use.
+ */
+#define PBUF_POOL_DEFINE(name, num, payload_size)												\
+	static uint8_t __##name##_storage[(num) * PBUF_BLOCK_SIZE(payload_size)]					\
+		__attribute__((aligned(sizeof(void *))));												\
+	pbuf_pool_t name = { NULL, (payload_size), (num), 0, __##name##_storage }
+
+/**
+ * @brief Links every block of a pool onto its free list.
+ */
+void pbuf_pool_init(pbuf_pool_t *pool);
+
+/**
+ * @brief Takes a block off the pool in constant time. Safe to call from ISRs.
+ * @return A block holding one reference with no payload, or NULL if the pool is exhausted.
+ */
+pbuf_t *pbuf_alloc(pbuf_pool_t *pool);
+
+/**
+ * @brief Adds a reference to a packet, e.g. before handing it to a second consumer. Safe to call from ISRs.
+ */
+void pbuf_ref(pbuf_t *pb);
+
+/**
+ * @brief Drops a reference to a packet. Blocks whose last reference goes away return to their pool,
+ * each in constant time. Safe to call from ISRs.
+ */
+void pbuf_unref(pbuf_t *pb);
+
+/**
+ * @brief Appends 'tail' to the end of the packet starting at 'head'.
+ * @details The caller's reference to 'tail' is handed over to the chain.
+ */
+void pbuf_chain(pbuf_t *head, pbuf_t *tail);
+
+/**
+ * @brief Total payload bytes across a packet.
+ */
+unsigned int pbuf_total_len(const pbuf_t *pb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_PBUF_H_ */
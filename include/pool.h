@@ -0,0 +1,125 @@
+/*
+ * pool.h
+ *
+ *  Created on: Jul 18, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_POOL_H_
+#define INCLUDE_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "port_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Free block link, stored in the first word of every free block.
+ */
+typedef struct pool_block {
+	struct pool_block *next;
+} pool_block_t;
+
+/**
+ * @brief Fixed-size block pool. Allocation and release are a single free list push or pop,
+ * so they take constant time, are safe from ISRs, and can't fragment.
+ */
+typedef struct pool {
+	pool_block_t *free;				/* singly linked free list */
+	unsigned int block_size;		/* bytes per block, word-aligned */
+	unsigned int num_blocks;		/* blocks in the pool */
+	unsigned int num_free;			/* blocks currently on the free list */
+	unsigned int min_free;			/* low-water mark of num_free */
+	uint8_t *start;					/* first byte of pool storage */
+	uint8_t *end;					/* one past the last byte of pool storage */
+} pool_t;
+
+/**
+ * @brief Snapshot of a pool's usage.
+ */
+typedef struct pool_stats {
+	unsigned int block_size;
+	unsigned int num_blocks;
+	unsigned int in_use;			/* blocks currently allocated */
+	unsigned int peak;				/* most blocks ever allocated at once */
+} pool_stats_t;
+
+/**
+ * @brief Bytes taken by one block of the given size once rounded up to keep blocks word-aligned.
+ */
+#define POOL_BLOCK_SIZE(size)	\
+	((((size) < sizeof(pool_block_t) ? sizeof(pool_block_t) : (size)) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+/**
+ * @name Generic pools
+ * @{
+ */
+
+/**
+ * @brief Carves the storage into blocks and links them into the free list.
+ * @param[in] storage Word-aligned buffer of at least num_blocks * POOL_BLOCK_SIZE(block_size) bytes.
+ */
+void pool_init(pool_t *pool, void *storage, unsigned int block_size, unsigned int num_blocks);
+
+/**
+ * @brief Takes a block from the pool.
+ * @return The block, or NULL if the pool is exhausted.
+ */
+void *pool_alloc(pool_t *pool);
+
+/**
+ * @brief Returns a block to the pool it was allocated from.
+ */
+void pool_free(pool_t *pool, void *block);
+
+/**
+ * @brief Reads the pool's usage statistics.
+ */
+void pool_get_stats(pool_t *pool, pool_stats_t *stats);
+
+/** @} */
+
+#if (CONFIG_STATIC_ALLOCATION == 1)
+
+/**
+ * @name System heap
+ * @brief Size classes carved from a static heap of CONFIG_STATIC_HEAP_SIZE bytes.
+ * @details Kernel objects, thread stacks and message buffers should be allocated here rather than
+ * declared as globals. The classes are listed in CONFIG_STATIC_POOL_CLASSES from smallest to largest.
+ * @{
+ */
+
+/**
+ * @brief Builds every size class. Call after sched_init() and before anything is allocated from the system heap.
+ */
+void pool_sys_init(void);
+
+/**
+ * @brief Allocates from the smallest size class that fits, moving up a class if it's exhausted.
+ * @return The block, or NULL if no class large enough has a free block.
+ */
+void *pool_sys_alloc(size_t size);
+
+/**
+ * @brief Returns a block to the size class it came from.
+ */
+void pool_sys_free(void *block);
+
+/**
+ * @brief Reads the usage statistics of the given size class.
+ * @return 0 on success, -1 if there's no such class.
+ */
+int pool_sys_get_stats(unsigned int cls, pool_stats_t *stats);
+
+/** @} */
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_POOL_H_ */
@@ -17,6 +17,21 @@
 #include "irq.h"
 #include "sched.h"
 #include "thread.h"
+#include "mutex.h"
+#include "cond.h"
+#include "sema.h"
+#include "mbox.h"
+#include "flags.h"
+#include "notify.h"
+#include "rwlock.h"
+#include "topic.h"
+#include "pbuf.h"
+#include "stage.h"
+#include "pool.h"
+#include "heap.h"
+#include "jobq.h"
+#include "coro.h"
+#include "ao.h"
 
 #include "port.h"
 
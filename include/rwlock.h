@@ -0,0 +1,88 @@
+/*
+ * rwlock.h
+ *
+ *  Created on: Jul 9, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_RWLOCK_H_
+#define INCLUDE_RWLOCK_H_
+
+#include <stdbool.h>
+
+#include "thread.h"
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Readers-writer lock with writer preference.
+ * @details Readers share the lock and only touch a counter, so they never block each other.
+ * Once a writer is waiting, new readers queue up behind it. The number of readers inside
+ * at once is capped by max_readers, which bounds how long a writer can be held off.
+ */
+typedef struct rwlock {
+	unsigned int readers;			/* readers currently holding the lock */
+	unsigned int max_readers;		/* admission bound for concurrent readers */
+	volatile thread_t *writer;		/* writer currently holding the lock, NULL if none */
+	wait_queue_t read_waiters;		/* threads in STATUS_RWLOCK_BLOCKED waiting to read */
+	wait_queue_t write_waiters;		/* threads in STATUS_RWLOCK_BLOCKED waiting to write */
+} rwlock_t;
+
+/**
+ * @brief Prepares an unlocked readers-writer lock.
+ * @param[in] max_readers Maximum number of concurrent readers, UINT_MAX for no bound.
+ */
+void rwlock_init(rwlock_t *rw, unsigned int max_readers);
+
+/**
+ * @brief Takes the lock for reading, blocking for at most the given time.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if the lock was taken, false if the timeout expired first.
+ */
+bool rwlock_timedrdlock(rwlock_t *rw, unsigned int ms);
+
+/**
+ * @brief Takes the lock for reading, blocking until it is available.
+ */
+void rwlock_rdlock(rwlock_t *rw);
+
+/**
+ * @brief Takes the lock for reading only if it is available right now.
+ */
+bool rwlock_tryrdlock(rwlock_t *rw);
+
+/**
+ * @brief Releases a read hold.
+ */
+void rwlock_rdunlock(rwlock_t *rw);
+
+/**
+ * @brief Takes the lock for writing, blocking for at most the given time.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if the lock was taken, false if the timeout expired first.
+ */
+bool rwlock_timedwrlock(rwlock_t *rw, unsigned int ms);
+
+/**
+ * @brief Takes the lock for writing, blocking until it is available.
+ */
+void rwlock_wrlock(rwlock_t *rw);
+
+/**
+ * @brief Takes the lock for writing only if it is available right now.
+ */
+bool rwlock_trywrlock(rwlock_t *rw);
+
+/**
+ * @brief Releases the write hold. Must be called by the writer.
+ */
+void rwlock_wrunlock(rwlock_t *rw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_RWLOCK_H_ */
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <limits.h>
 
 #include "port_config.h"
 
@@ -76,15 +77,72 @@ typedef enum {
     STATUS_FLAG_BLOCKED_ALL,
     STATUS_MBOX_BLOCKED,
     STATUS_COND_BLOCKED,
+    STATUS_SEMA_BLOCKED,
+    STATUS_RWLOCK_BLOCKED,
+    STATUS_TOPIC_BLOCKED,
+    STATUS_MULTI_BLOCKED,       /* blocked in sched_wait_any() */
+    STATUS_NOTIFY_BLOCKED,      /* blocked in notify_wait() */
+    STATUS_JOIN_BLOCKED,        /* blocked in thread_join() */
     STATUS_RUNNING,
     STATUS_PENDING,
     STATUS_NUMOF
 } thread_status_t;
 
+/**
+ * @brief Why a thread blocked on a kernel object was put back on the run queue.
+ */
+typedef enum {
+    WAKE_SIGNALLED,             /* the object was signalled, or ownership handed over */
+    WAKE_TIMEOUT,               /* the timeout expired first */
+    WAKE_NUMOF
+} wake_reason_t;
+
+/**
+ * @brief Timeout value for blocking calls that never time out.
+ */
+#define SCHED_WAIT_FOREVER                                      UINT_MAX
+
+/**
+ * @brief Kinds of kernel objects sched_wait_any() can block on.
+ */
+typedef enum {
+    WAIT_OBJ_SEMA,              /* sema_t, a count is taken */
+    WAIT_OBJ_MBOX,              /* mbox_t, a message is received into *(void **) arg */
+    WAIT_OBJ_FLAGS,             /* flags_t, any flag in arg is set, arg is replaced by the snapshot */
+    WAIT_OBJ_NUMOF
+} wait_obj_type_t;
+
+/**
+ * @brief One entry of the object set passed to sched_wait_any().
+ */
+typedef struct wait_obj {
+    unsigned int type;          /* wait_obj_type_t */
+    void *obj;
+    uintptr_t arg;              /* type-specific request and result */
+} wait_obj_t;
+
+/**
+ * @brief Outcomes of the scheduler decisions taken by the tick and by yields.
+ */
+typedef struct sched_switch_stats {
+    uint32_t switches;          /* a different thread was picked and a full switch happened */
+    uint32_t skipped;           /* the running thread was kept, and resumed without saving its whole context */
+} sched_switch_stats_t;
+
 void sched_init(void);
 
 void sched_add(volatile thread_t *new, volatile unsigned int priority);
 
+/**
+ * @brief Adds several threads in a single critical section.
+ * @details With an empty run queue and threads listed in ascending priority order, the run queue is
+ * built balanced in linear time instead of by n rebalancing inserts. Use it at boot or after sched_end().
+ * @param[in] threads Threads to add.
+ * @param[in] priorities Priority of each thread.
+ * @param[in] n Number of threads.
+ */
+void sched_add_batch(thread_t *const *threads, const unsigned int *priorities, unsigned int n);
+
 void sched_register(volatile thread_t *new);
 
 void sched_deregister(volatile thread_t *new);
@@ -101,6 +159,16 @@ void sched_yield(void);
 
 void sched_yield_higher(void);
 
+/**
+ * @brief Hands the rest of the caller's time slice directly to another thread, without a scheduling decision.
+ * @details The slice stays billed to the thread it was scheduled for, so the recipient's fair share is untouched
+ * and the caller's place in the cycle is kept. Useful when the caller knows exactly who must run next, like a
+ * producer handing off to its consumer. Only call from threads.
+ * @param[in] thr Thread to run next.
+ * @return False without switching if the thread isn't runnable or is the caller, true once the caller runs again.
+ */
+bool sched_switch_to(thread_t *thr);
+
 sched_status_t sched_get_status(void);
 
 void sched_set_status(sched_status_t status);
@@ -110,8 +178,30 @@ void sched_clear_status(sched_status_t status);
 thread_t *sched_current_thread(void);
 unsigned int sched_thread_count(void);
 
+/**
+ * @brief Blocks on several kernel objects at once until one of them can be consumed.
+ * @details Exactly one object is consumed: the one whose index is returned.
+ * @param[in] objs Objects to wait on, at most CONFIG_WAIT_ANY_MAX of them.
+ * @param[in] n Number of objects.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return Index of the object that was consumed, or -1 if the timeout expired first.
+ */
+int sched_wait_any(wait_obj_t *objs, unsigned int n, unsigned int ms);
+
 void sched_register_cb(void (*cb)(void *arg), void *params);
-void sched_task_exit(void);
+
+/**
+ * @brief Reads how often the tick and yields switched threads, and how often they kept the running one.
+ */
+void sched_get_switch_stats(sched_switch_stats_t *stats);
+
+/**
+ * @brief Retires the running thread. It becomes a zombie holding its exit code until joined.
+ * @details Threads returning from their runnable end up here through arch_task_exit().
+ * @param[in] exit_code Value reported to thread_join().
+ */
+void __attribute__((noreturn)) sched_task_exit(int exit_code);
+
 #ifdef __cplusplus
 }
 #endif
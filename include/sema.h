@@ -0,0 +1,59 @@
+/*
+ * sema.h
+ *
+ *  Created on: Jul 6, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_SEMA_H_
+#define INCLUDE_SEMA_H_
+
+#include <stdbool.h>
+
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counting semaphore. A post with waiters hands the count straight to the oldest one.
+ */
+typedef struct sema {
+	unsigned int count;
+	wait_queue_t waiters;		/* threads in STATUS_SEMA_BLOCKED or STATUS_MULTI_BLOCKED */
+} sema_t;
+
+/**
+ * @brief Prepares a semaphore with the given initial count.
+ */
+void sema_init(sema_t *sem, unsigned int count);
+
+/**
+ * @brief Takes a count, blocking for at most the given time.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if a count was taken, false if the timeout expired first.
+ */
+bool sema_timedwait(sema_t *sem, unsigned int ms);
+
+/**
+ * @brief Takes a count, blocking until one is available.
+ */
+void sema_wait(sema_t *sem);
+
+/**
+ * @brief Takes a count only if one is available.
+ * @return True if a count was taken.
+ */
+bool sema_trywait(sema_t *sem);
+
+/**
+ * @brief Gives a count back. Safe to call from ISRs.
+ */
+void sema_post(sema_t *sem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_SEMA_H_ */
@@ -0,0 +1,97 @@
+/*
+ * stage.h
+ *
+ *  Created on: Jul 17, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_STAGE_H_
+#define INCLUDE_STAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "thread.h"
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct stage stage_t;
+
+/**
+ * @brief Stage handler. Receives up to a batch of items, contiguous in the stage's input queue.
+ * @details Items are only valid for the duration of the call. Forward them with stage_push() on the next stage.
+ */
+typedef void (*stage_fn_t)(stage_t *st, void **items, unsigned int n);
+
+/**
+ * @brief Pipeline stage: a thread draining a bounded queue of pointer-sized items in batches.
+ * @details Producers block while the queue is full instead of dropping items (backpressure).
+ * The stage thread is only woken once a full batch is queued, or once flush_ms passes with a
+ * partial batch, so a context switch is paid per batch rather than per item.
+ */
+struct stage {
+	void **slots;					/* bounded input queue storage */
+	unsigned int size;				/* queue capacity */
+	unsigned int head;				/* slot holding the oldest item */
+	unsigned int count;				/* items queued */
+
+	unsigned int batch;				/* items handed to the handler per wakeup */
+	unsigned int flush_ms;			/* how long a partial batch may wait, SCHED_WAIT_FOREVER to always wait for a full one */
+	stage_fn_t fn;
+	void *ctx;						/* user data for the handler */
+
+	wait_queue_t consumer;			/* the stage thread, in STATUS_RECEIVE_BLOCKED */
+	wait_queue_t producers;			/* upstream threads in STATUS_SEND_BLOCKED on a full queue */
+
+	uint32_t items;					/* items processed */
+	uint32_t batches;				/* handler invocations */
+	uint32_t stalls;				/* pushes that had to wait for room */
+	unsigned int depth_max;			/* queue depth high-water mark */
+};
+
+/**
+ * @brief Prepares a stage.
+ * @param[in] slots Storage for the input queue.
+ * @param[in] size Capacity of the input queue, at least 'batch'.
+ * @param[in] batch Items per handler call.
+ * @param[in] flush_ms Longest time a partial batch waits before being processed anyway. Nonzero.
+ * @param[in] fn Handler.
+ * @param[in] ctx User data for the handler.
+ */
+void stage_init(stage_t *st, void **slots, unsigned int size, unsigned int batch,
+				unsigned int flush_ms, stage_fn_t fn, void *ctx);
+
+/**
+ * @brief Builds the stage thread on the given TCB and stack and adds it to the scheduler.
+ * @param[in] stack Lowest address of the stage thread's stack.
+ * @param[in] stack_size Size of the stack in bytes.
+ * @param[in] shares Scheduling priority of the stage thread.
+ */
+void stage_spawn(stage_t *st, thread_t *thr, void *stack, size_t stack_size, unsigned int shares);
+
+/**
+ * @brief Queues an item, blocking for at most the given time in total while the queue is full.
+ * @param[in] ms Timeout in milliseconds, SCHED_WAIT_FOREVER, or 0 to never block (e.g. from ISRs).
+ * @return True if the item was queued.
+ */
+bool stage_timedpush(stage_t *st, void *item, unsigned int ms);
+
+/**
+ * @brief Queues an item, blocking while the queue is full.
+ */
+void stage_push(stage_t *st, void *item);
+
+/**
+ * @brief Current number of queued items.
+ */
+unsigned int stage_depth(stage_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_STAGE_H_ */
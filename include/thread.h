@@ -8,9 +8,13 @@
 #ifndef INCLUDE_THREAD_H_
 #define INCLUDE_THREAD_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "sched.h"
 #include "sleep_queue.h"
 #include "thread_impl.h"
+#include "hal.h"
 
 //typedef struct sched_impl_client sched_impl_client_t;
 //typedef struct sleep_queue_entry sleep_queue_entry_t;
@@ -20,6 +24,97 @@
 typedef struct thread {
 	thread_impl_t base;
 	irq_lock_t cs_lock;
+	volatile unsigned int notify;	/* direct-to-task notification word, see notify.h */
+
+	int exit_code;					/* valid once the thread is a zombie */
+	wait_queue_t joiners;			/* the thread blocked in thread_join(), at most one */
+	void *stack;					/* stack to release when joined, NULL if the caller owns it */
 } thread_t;
 
+/**
+ * @brief Link-time thread definition, collected in the thread_defs section and started by sched_init().
+ */
+typedef struct thread_def {
+	thread_t *thr;
+	uint8_t *stack;
+	size_t stack_size;
+	unsigned int shares;
+	thread_fn_t fn;
+	void *arg;
+
+	#if (ARCH_HAS_CONTEXT_INIT == 1)
+		arch_context_t ctx;			/* initial context, copied to the top of the stack */
+	#endif
+} thread_def_t;
+
+#if (ARCH_HAS_CONTEXT_INIT == 1)
+	#define __THREAD_DEF_CTX(fn, arg)		, .ctx = ARCH_CONTEXT_INIT(fn, arg)
+#else
+	#define __THREAD_DEF_CTX(fn, arg)
+#endif
+
+/**
+ * @def THREAD_DEFINE
+ * @brief Defines a thread that sched_init() adds to the scheduler, with no run-time setup code.
+ * @details The TCB and the stack get their own .bss.thread_tcbs.name and .bss.thread_stacks.name
+ * sections, so every stack shows up with its size in the map file.
+ * @param[in] name			Name of the thread_t.
+ * @param[in] _fn			Thread runnable.
+ * @param[in] _arg			Argument of the runnable. Must be a link-time constant.
+ * @param[in] _stack_size	Size of the stack in bytes.
+ * @param[in] _shares		Scheduling priority.
+ */
+#define THREAD_DEFINE(name, _fn, _arg, _stack_size, _shares)												\
+	thread_t name __attribute__((section(".bss.thread_tcbs." #name)));								\
+	static uint8_t __thread_stack_##name[(_stack_size)]												\
+		__attribute__((section(".bss.thread_stacks." #name), aligned(sizeof(arch_reg_t))));		\
+	static const thread_def_t __thread_def_##name													\
+		__attribute__((section("thread_defs"), used, aligned(sizeof(void *)))) = {					\
+		.thr = &name, .stack = __thread_stack_##name, .stack_size = (_stack_size),					\
+		.shares = (_shares), .fn = (thread_fn_t) (_fn), .arg = (void *) (_arg)							\
+		__THREAD_DEF_CTX(_fn, _arg)																	\
+	}
+
+/**
+ * @brief Builds a thread on caller-owned storage. Add it to the scheduler with sched_add().
+ * @param[in] stack Lowest address of the stack.
+ * @param[in] stack_size Size of the stack in bytes.
+ */
+void thread_init(thread_t *thr, thread_fn_t fn, void *arg, void *stack, size_t stack_size);
+
+/**
+ * @brief Creates a thread with a TCB and stack taken from the kernel allocator, and adds it to the scheduler.
+ * @details Both come from the system pools with CONFIG_STATIC_ALLOCATION, otherwise from the system heap.
+ * They're released by thread_join(), so every thread made here must be joined.
+ * @return The new thread, or NULL if either allocation failed.
+ */
+thread_t *thread_create(thread_fn_t fn, void *arg, size_t stack_size, unsigned int shares);
+
+/**
+ * @brief Ends the calling thread. Returning from the runnable does the same.
+ */
+void __attribute__((noreturn)) thread_exit(int exit_code);
+
+/**
+ * @brief Waits for a thread to exit, then releases its TCB and stack if thread_create() allocated them.
+ * @details Only one thread may join a given thread.
+ * @return The exit code of the thread.
+ */
+int thread_join(thread_t *thr);
+
+#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+
+/**
+ * @brief Most stack bytes the thread has ever used, as of the idle thread's last measurement of it.
+ * @details Measurements are taken lazily in idle time, one thread per pass, so the value can lag behind.
+ */
+size_t thread_stack_high_water(thread_t *thr);
+
+/**
+ * @brief Size of the thread's stack in bytes.
+ */
+size_t thread_stack_size(thread_t *thr);
+
+#endif
+
 #endif /* INCLUDE_THREAD_H_ */
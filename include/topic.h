@@ -0,0 +1,68 @@
+/*
+ * topic.h
+ *
+ *  Created on: Jul 13, 2020
+ *      Author: krad2
+ */
+
+#ifndef INCLUDE_TOPIC_H_
+#define INCLUDE_TOPIC_H_
+
+#include <stdbool.h>
+
+#include "wait_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Latest-value publish / subscribe topic guarded by a sequence counter.
+ * @details The counter is odd while a publish is in progress and advances by 2 per publish.
+ * Subscribers copy the value without any lock and retry if the counter moved underneath them,
+ * so reading never delays a publisher. Publishers serialize among themselves for the length of
+ * the copy only, which makes publishing safe from ISRs.
+ */
+typedef struct topic {
+	volatile unsigned int seq;		/* sequence counter, odd while a publish is in progress */
+	void *data;						/* storage for the latest value */
+	unsigned int size;				/* size of a value in bytes */
+	wait_queue_t subscribers;		/* threads in STATUS_TOPIC_BLOCKED waiting for a new value */
+} topic_t;
+
+/**
+ * @brief Prepares a topic over caller-provided storage. Nothing is published yet.
+ */
+void topic_init(topic_t *tp, void *storage, unsigned int size);
+
+/**
+ * @brief Publishes a new value and wakes every blocked subscriber. Never blocks, safe to call from ISRs.
+ */
+void topic_publish(topic_t *tp, const void *value);
+
+/**
+ * @brief Copies a consistent snapshot of the latest value without blocking.
+ * @param[out] dst Destination for the value.
+ * @return Generation of the value that was copied, 0 if nothing was published yet.
+ */
+unsigned int topic_read(topic_t *tp, void *dst);
+
+/**
+ * @brief Blocks until a generation newer than *gen is published, then copies it.
+ * @param[inout] gen Last generation seen by the caller, updated to the one copied.
+ * @param[out] dst Destination for the value.
+ * @param[in] ms Timeout in milliseconds, or SCHED_WAIT_FOREVER.
+ * @return True if a newer value was copied, false if the timeout expired first.
+ */
+bool topic_timedwait(topic_t *tp, unsigned int *gen, void *dst, unsigned int ms);
+
+/**
+ * @brief Blocks until a generation newer than *gen is published, then copies it.
+ */
+void topic_wait(topic_t *tp, unsigned int *gen, void *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDE_TOPIC_H_ */
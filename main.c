@@ -3,13 +3,12 @@
 #define NUM_THREADS		6
 #define STACK_SIZE		256
 
-volatile uint8_t sched_isr_stack[CONFIG_ISR_STACK_SIZE];
-
 
 //volatile sched_t sched_g;
 
-volatile thread_t tcbs[NUM_THREADS];
-volatile uint8_t sched_test_stacks[NUM_THREADS][STACK_SIZE];
+/* taken from the static heap in main() */
+thread_t *tcbs[NUM_THREADS];
+uint8_t *sched_test_stacks[NUM_THREADS];
 volatile uint32_t run_counts[NUM_THREADS] = { 0 };
 
 /*-----------------------------------------------------------*/
@@ -28,6 +27,113 @@ void profile_end(void) {
 	rc++;
 }
 
+/*-----------------------------------------------------------*/
+
+#if (CONFIG_BENCHMARK_MODE == 1)
+
+/**
+ * Wake latency benchmarks, measured in SMCLK cycles on TA2 so the tick profiling on TA1 doesn't interfere.
+ * The signaller stamps the time, signals the higher priority waiter and yields to it, and the waiter
+ * accumulates the elapsed time once it runs. Both paths share the same context switch, so the
+ * difference between the averages is the cost of the primitive itself.
+ */
+
+sema_t bench_sema;
+volatile uint16_t bench_stamp;
+
+volatile uint32_t bench_notify_cycles = 0;
+volatile uint16_t bench_notify_runs = 0;
+volatile uint32_t bench_sema_cycles = 0;
+volatile uint16_t bench_sema_runs = 0;
+volatile uint32_t bench_handoff_cycles = 0;
+volatile uint16_t bench_handoff_runs = 0;
+volatile uint16_t bench_handoff_stamp;
+volatile bool bench_handoff_pending = false;
+
+void bench_waiter(void *arg) {
+	while (1) {
+		notify_wait();
+		bench_notify_cycles += (uint16_t) (TA2R - bench_stamp);
+		bench_notify_runs++;
+
+		sema_wait(&bench_sema);
+		bench_sema_cycles += (uint16_t) (TA2R - bench_stamp);
+		bench_sema_runs++;
+	}
+}
+
+void bench_signaller(void *arg) {
+	thread_t *waiter = (thread_t *) arg;
+
+	while (1) {
+		bench_stamp = TA2R;
+		notify_increment(waiter);
+		sched_yield_higher();
+
+		bench_stamp = TA2R;
+		sema_post(&bench_sema);
+		sched_yield_higher();
+
+		arch_yield();
+	}
+}
+
+/* the waiter outranks everything so yield_higher() picks it, sched_init() adds both */
+THREAD_DEFINE(bench_waiter_thr, bench_waiter, NULL, STACK_SIZE, NUM_THREADS + 2);
+THREAD_DEFINE(bench_signaller_thr, bench_signaller, &bench_waiter_thr, STACK_SIZE, 1);
+
+/**
+ * Directed handoff latency. The donor stamps the time and hands its slice to the lowest priority
+ * recipient, which would otherwise rarely be picked, and the recipient gives control back through
+ * an ordinary yield. No object is signalled, so this is the cost of sched_switch_to() alone.
+ * The recipient also gets ordinary slices, so it only counts runs that a pending handoff started.
+ */
+
+void bench_recipient(void *arg) {
+	while (1) {
+		uint16_t now = TA2R;
+
+		irq_lock();
+		if (bench_handoff_pending) {
+			bench_handoff_cycles += (uint16_t) (now - bench_handoff_stamp);
+			bench_handoff_runs++;
+			bench_handoff_pending = false;
+		}
+		irq_unlock();
+
+		sched_yield();
+	}
+}
+
+void bench_donor(void *arg) {
+	thread_t *recipient = (thread_t *) arg;
+
+	while (1) {
+
+		/* locked so no tick can run the recipient between the stamp and the handoff */
+		irq_lock();
+		bench_handoff_stamp = TA2R;
+		bench_handoff_pending = true;
+		sched_switch_to(recipient);
+		bench_handoff_pending = false;
+		irq_unlock();
+	}
+}
+
+THREAD_DEFINE(bench_recipient_thr, bench_recipient, NULL, STACK_SIZE, 1);
+THREAD_DEFINE(bench_donor_thr, bench_donor, &bench_recipient_thr, STACK_SIZE, 1);
+
+void bench_init(void) {
+	TA2CTL = MC_0 | TACLR;
+	TA2CTL = MC_2 | TASSEL_2;
+
+	sema_init(&bench_sema, 0);
+}
+
+#endif
+
+/*-----------------------------------------------------------*/
+
 //https://www.desmos.com/calculator/bc87vbzhtr approximation calculator
 // tradeoff with the timer divider is between resolution and max sleep length without intervention
 
@@ -148,21 +254,36 @@ int main(void)
 	P1IFG &= ~BIT1;                           // P1.1 IFG cleared
 	P1IE |= BIT1;
 
-	tcbs[0].base.sp = arch_init_stack(sched_test_stacks[0] + 256, a, run_counts[0]);
-	tcbs[1].base.sp = arch_init_stack(sched_test_stacks[1] + 256, b, run_counts[1]);
-	tcbs[2].base.sp = arch_init_stack(sched_test_stacks[2] + 256, c, run_counts[2]);
-	tcbs[3].base.sp = arch_init_stack(sched_test_stacks[3] + 256, d, run_counts[3]);
-	tcbs[4].base.sp = arch_init_stack(sched_test_stacks[4] + 256, e, run_counts[4]);
-	tcbs[5].base.sp = arch_init_stack(sched_test_stacks[5] + 256, f, run_counts[5]);
-
 	__disable_interrupt();
 	sched_init();
+	pool_sys_init();
+	heap_sys_init();
 
-	for (int i = 0; i < 6; ++i) {
-		tcbs[i].cs_lock = 1;
-		sched_add(&tcbs[i], i + 1);
+	for (int i = 0; i < NUM_THREADS; ++i) {
+		tcbs[i] = pool_sys_alloc(sizeof(thread_t));
+		sched_test_stacks[i] = pool_sys_alloc(STACK_SIZE);
+		if (tcbs[i] == NULL || sched_test_stacks[i] == NULL) panic(PANIC_ASSERT_FAIL, "Static heap too small");
 	}
 
+	thread_init(tcbs[0], (thread_fn_t) a, (void *) &run_counts[0], sched_test_stacks[0], STACK_SIZE);
+	thread_init(tcbs[1], (thread_fn_t) b, (void *) &run_counts[1], sched_test_stacks[1], STACK_SIZE);
+	thread_init(tcbs[2], (thread_fn_t) c, (void *) &run_counts[2], sched_test_stacks[2], STACK_SIZE);
+	thread_init(tcbs[3], (thread_fn_t) d, (void *) &run_counts[3], sched_test_stacks[3], STACK_SIZE);
+	thread_init(tcbs[4], (thread_fn_t) e, (void *) &run_counts[4], sched_test_stacks[4], STACK_SIZE);
+	thread_init(tcbs[5], (thread_fn_t) f, (void *) &run_counts[5], sched_test_stacks[5], STACK_SIZE);
+
+	#if (CONFIG_BENCHMARK_MODE == 1)
+		bench_init();
+	#endif
+
+	/**
+	 * Staged in ascending priority order, so the run queue is built in one pass when it starts out empty.
+	 * With CONFIG_BENCHMARK_MODE, sched_init() has already queued the THREAD_DEFINE benchmark threads,
+	 * so these are inserted one at a time instead.
+	 */
+	static const unsigned int priorities[NUM_THREADS] = { 1, 2, 3, 4, 5, 6 };
+	sched_add_batch(tcbs, priorities, NUM_THREADS);
+
 	sched_start();
 
 	while (1) {
@@ -20,11 +20,24 @@
 #define CONFIG_ISR_STACK_SIZE 										256
 #define CONFIG_IDLE_STACK_SIZE										128
 
+// carve the idle stack, and optionally the kernel stack, out of the unused part of main()'s stack at boot
+// the boot stack then needs that many free bytes below main()'s frame, kernel stack on top
+#define CONFIG_IDLE_USE_BOOT_STACK									1
+#define CONFIG_ISR_USE_BOOT_STACK									0
+
 // static allocation requires a preallocated heap buffer with a certain size
-#define CONFIG_STATIC_ALLOCATION
-#define CONFIG_STATIC_HEAP_SIZE
+#define CONFIG_STATIC_ALLOCATION									1
+#define CONFIG_STATIC_HEAP_SIZE										4096
+
+// fixed-block size classes carved from the static heap, POOL_CLASS(block size, block count), smallest first
+#define CONFIG_STATIC_POOL_CLASSES									\
+	POOL_CLASS(16, 16)												\
+	POOL_CLASS(96, 12)												\
+	POOL_CLASS(256, 10)
 
-#define CONFIG_DYNAMIC_ALLOCATION
+// dynamic allocation manages a static buffer of the given size with a TLSF heap, threads only
+#define CONFIG_DYNAMIC_ALLOCATION									1
+#define CONFIG_DYNAMIC_HEAP_SIZE									1024
 
 #define CONFIG_SCHED_RR												0
 #define CONFIG_SCHED_VTRR 											1
@@ -33,7 +46,10 @@
 
 #define CONFIG_USE_IDLE_HOOK                     					0
 #define CONFIG_USE_TICK_HOOK                     					0
-#define CONFIG_CHECK_FOR_STACK_OVERFLOW          					0
+// paints stacks, checks a canary on every switch and lets idle measure per-thread high-water marks
+#define CONFIG_CHECK_FOR_STACK_OVERFLOW          					1
+// bytes of stack the idle thread measures per pass with interrupts locked
+#define CONFIG_STACK_SCAN_CHUNK										16
 
 #define CONFIG_DEBUG_MODE											1
 #define CONFIG_BENCHMARK_MODE										1
@@ -43,6 +59,15 @@
 
 #define CONFIG_PANIC_DUMP_SIZE										128
 
+// upper bound on the number of objects a thread can block on with sched_wait_any()
+#define CONFIG_WAIT_ANY_MAX											4
+
+// how often a coroutine host re-checks waits it can't block on, like CORO_WAIT_UNTIL() conditions
+#define CONFIG_CORO_POLL_MS											10
+
+// distinct active object priorities per ao_kernel_t, one ready bit each
+#define CONFIG_AO_PRIORITIES										8
+
 // priority inheritance should force a non-dumb wait queue implementation
 
 #endif /* PORT_CONFIG_H_ */
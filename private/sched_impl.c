@@ -5,8 +5,10 @@
  *      Author: krad2
  */
 
+#include "sched.h"
 #include "sched_impl.h"
 #include "thread_impl.h"
+#include "thread.h"
 #include "hal.h"
 
 /*-----------------------------------------------------------*/
@@ -29,11 +31,21 @@
 
 /*-----------------------------------------------------------*/
 
-static volatile thread_impl_t sched_idle_thread;
-volatile uint8_t idle_stack[CONFIG_IDLE_STACK_SIZE];
+/* a full thread_t so irq_lock() has a lock counter to nest on while idle or before the scheduler starts */
+static volatile thread_t sched_idle_thread;
+
+#if (CONFIG_IDLE_USE_BOOT_STACK != 1)
+	volatile uint8_t idle_stack[CONFIG_IDLE_STACK_SIZE];
+#endif
 
 static int idle(void *arg) {
 	while (1) {
+
+		/* measure one stack per pass so idle time pays for the statistics */
+		#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+			thread_impl_stack_scan_next();
+		#endif
+
 		arch_idle();
 	}
 
@@ -46,33 +58,94 @@ static int idle(void *arg) {
 
 volatile sched_impl_t sched_p;
 
+void sched_impl_idle_init(void *stack, size_t stack_size) {
+	thread_impl_init((thread_impl_t *) &sched_idle_thread, stack, stack_size, idle, NULL);
+}
+
+/**
+ * @brief Gives the idle thread its own stack, unless arch_sched_start() hands it a slice of the boot stack later.
+ */
+static inline void sched_impl_idle_begin(void) {
+	#if (CONFIG_IDLE_USE_BOOT_STACK != 1)
+		sched_impl_idle_init((void *) idle_stack, CONFIG_IDLE_STACK_SIZE);
+	#endif
+}
+
+/**
+ * @brief Takes the idle thread off the scan list. With CONFIG_IDLE_USE_BOOT_STACK, main() takes its stack back after sched_end().
+ */
+static inline void sched_impl_idle_end(void) {
+	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+		thread_impl_stack_release((thread_impl_t *) &sched_idle_thread);
+	#endif
+}
+
+static void sched_impl_arm_timeout(thread_impl_t *client, unsigned int wake_time);
+
+/**
+ * @brief Checks if the active thread took itself off the run queue and must be switched away from.
+ */
+static inline bool sched_impl_active_blocked(void) {
+	return sched_p.sched_active_thread->status < STATUS_RUNNING;
+}
+
 #define DECLARE_SCHED_IMPL_FNS(type)																		\
+	static void sched_impl_plan_later(void) {																\
+		if ((sched_p.state & SCHED_STATUS_THREAD_COUNT_MASK) >= 1 &&										\
+			!type##_planned((type##_mgr_t *) &sched_p.instance)) {											\
+			arch_pend_plan();																				\
+		}																									\
+	}																										\
+																											\
 	void sched_impl_init(void) {																			\
 		type##_init((type##_mgr_t *) &sched_p.instance);													\
 		sleep_queue_init((sleep_queue_t *) &sched_p.sleep_mgr);												\
 		sched_p.state = 0;																					\
+		sched_p.switches = 0;																				\
+		sched_p.switches_skipped = 0;																		\
 		sched_p.sched_active_thread = (thread_impl_t *) &sched_idle_thread;									\
-		thread_impl_init((thread_impl_t *) &sched_idle_thread, 												\
-						(void *) (idle_stack + CONFIG_IDLE_STACK_SIZE), idle, NULL);						\
+		sched_idle_thread.cs_lock = 1;																		\
+		sched_impl_idle_begin();																			\
 	}																										\
 																											\
 	void sched_impl_add(thread_impl_t *client, unsigned int priority) { 									\
 		type##_add((type##_mgr_t *) &sched_p.instance, (type##_client_t *) &client->rq_entry, priority);	\
+		client->status = STATUS_PENDING;																	\
 		sched_p.state += (1 << SCHED_STATUS_THREAD_COUNT_POS);												\
+		sched_impl_plan_later();																			\
+	}																										\
+																											\
+	void sched_impl_batch_init(sched_impl_batch_t *batch) {													\
+		type##_batch_init((type##_batch_t *) batch);														\
+	}																										\
+																											\
+	void sched_impl_batch_add(sched_impl_batch_t *batch, thread_impl_t *client, unsigned int priority) {	\
+		type##_batch_add((type##_batch_t *) batch, (type##_client_t *) &client->rq_entry, priority);		\
+		client->status = STATUS_PENDING;																	\
+	}																										\
+																											\
+	void sched_impl_add_batch(sched_impl_batch_t *batch) {													\
+		sched_p.state += (batch->len << SCHED_STATUS_THREAD_COUNT_POS);										\
+		type##_add_batch((type##_mgr_t *) &sched_p.instance, (type##_batch_t *) batch);						\
+		sched_impl_plan_later();																			\
 	}																										\
 																											\
 	void sched_impl_register(thread_impl_t *client) {														\
 		type##_register((type##_mgr_t *) &sched_p.instance, &client->rq_entry);								\
+		client->status = STATUS_PENDING;																	\
 		sched_p.state += (1 << SCHED_STATUS_THREAD_COUNT_POS);												\
+		sched_impl_plan_later();																			\
 	}																										\
 																											\
 	void sched_impl_deregister(thread_impl_t *client) {														\
 		type##_deregister((type##_mgr_t *) &sched_p.instance, &client->rq_entry);							\
 		sched_p.state -= (1 << SCHED_STATUS_THREAD_COUNT_POS);												\
+		sched_impl_plan_later();																			\
 	}																										\
 																											\
 	void sched_impl_reregister(thread_impl_t *client, unsigned int priority) {								\
 		type##_reregister((type##_mgr_t *) &sched_p.instance, &client->rq_entry, priority);  				\
+		sched_impl_plan_later();																			\
 	}																										\
 																											\
 	void sched_impl_start(void) {																			\
@@ -81,6 +154,7 @@ volatile sched_impl_t sched_p;
 																											\
 	void sched_impl_end(void) {																				\
 		type##_end((type##_mgr_t *) &sched_p.instance);														\
+		sched_impl_idle_end();																				\
 	}																										\
 																											\
 	void sched_impl_run(void) {																				\
@@ -90,26 +164,131 @@ volatile sched_impl_t sched_p;
 		} else {																							\
 			sched_p.sched_active_thread = (thread_impl_t *) &sched_idle_thread;								\
 		}																									\
+		sched_impl_plan_later();																			\
 	}																										\
 																											\
 	void sched_impl_yield(void) {																			\
-		if ((sched_p.state & SCHED_STATUS_THREAD_COUNT_MASK) > 1) {											\
+		if (sched_impl_active_blocked()) {																	\
+			sched_impl_run();																				\
+		} else if ((sched_p.state & SCHED_STATUS_THREAD_COUNT_MASK) > 1) {									\
 			type##_yield((sched_impl_mgr_t *) (type##_mgr_t *) &sched_p.instance);							\
 			sched_p.sched_active_thread = sched_impl_active_client((type##_mgr_t *) &sched_p.instance);		\
 		}																									\
+		sched_impl_plan_later();																			\
 	}																										\
 																											\
 	void sched_impl_yield_higher(void) {																	\
-		if ((sched_p.state & SCHED_STATUS_THREAD_COUNT_MASK) > 1) {											\
+		if (sched_impl_active_blocked()) {																	\
+			sched_impl_run();																				\
+		} else if ((sched_p.state & SCHED_STATUS_THREAD_COUNT_MASK) > 1) {									\
 			type##_yield_higher((sched_impl_mgr_t *) (type##_mgr_t *) &sched_p.instance);					\
 			sched_p.sched_active_thread = sched_impl_active_client((type##_mgr_t *) &sched_p.instance);		\
 		}																									\
+		sched_impl_plan_later();																			\
+	}																										\
+																											\
+	void sched_impl_switch_to(thread_impl_t *client) {														\
+		type##_switch_to((type##_mgr_t *) &sched_p.instance, (type##_client_t *) &client->rq_entry);		\
+		sched_p.sched_active_thread = client;																\
+	}																										\
+																											\
+	void sched_impl_plan(void) {																			\
+		if ((sched_p.state & SCHED_STATUS_THREAD_COUNT_MASK) >= 1) {										\
+			type##_plan((type##_mgr_t *) &sched_p.instance);												\
+		}																									\
 	}																										\
 																											\
 	void sched_impl_sleep_until(unsigned int wake_time) {													\
-		sleep_queue_push((sleep_queue_t *) &sched_p.sleep_mgr, 												\
-						(thread_impl_t *) sched_p.sched_active_thread, wake_time);							\
+		sched_impl_arm_timeout((thread_impl_t *) sched_p.sched_active_thread, wake_time);					\
+		sched_impl_block(STATUS_SLEEPING);																	\
+	}																										\
+																											\
+	void sched_impl_block(unsigned int status) {															\
 		sched_impl_deregister((thread_impl_t *) sched_p.sched_active_thread);								\
+		sched_p.sched_active_thread->status = status;														\
+	}																										\
+																											\
+	void sched_impl_unblock(thread_impl_t *client) {														\
+		sched_impl_register(client);																		\
+		if (sched_p.state & SCHED_STATUS_IN_IRQ) sched_p.state |= SCHED_STATUS_CONTEXT_SWITCH_REQUEST;		\
 	}																										\
 
 DECLARE_SCHED_IMPL_FNS(vtrr);
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @name Generic blocking on kernel objects with optional timeouts.
+ * @details A waiting thread is linked into an object wait queue through wq_entry and, if a timeout
+ * is requested, into the sleep queue through sq_entry. Whichever side wakes the thread first
+ * unlinks the other: O(1) for the wait queue, O(log n) for the sleep queue.
+ * @{
+ */
+
+static void sched_impl_arm_timeout(thread_impl_t *client, unsigned int wake_time) {
+	sleep_queue_push((sleep_queue_t *) &sched_p.sleep_mgr, client, wake_time);
+	client->sleeping = true;
+}
+
+void sched_impl_cancel_timeout(thread_impl_t *client) {
+	if (client->sleeping) {
+		sleep_queue_remove_node((sleep_queue_t *) &sched_p.sleep_mgr, client);
+		client->sleeping = false;
+	}
+}
+
+void sched_impl_wait_set(wait_queue_entry_t *set, unsigned int len, unsigned int status) {
+	thread_impl_t *me = (thread_impl_t *) sched_p.sched_active_thread;
+
+	/* arm one record per object, each record already names its queue and request */
+	for (unsigned int i = 0; i < len; ++i) {
+		set[i].thr = me;
+		set[i].index = i;
+		wait_queue_push_entry(set[i].que, &set[i]);
+	}
+
+	me->wait_set = set;
+	me->wait_set_len = len;
+	sched_impl_block(status);
+}
+
+void sched_impl_wait_set_until(wait_queue_entry_t *set, unsigned int len, unsigned int status, unsigned int wake_time) {
+	sched_impl_arm_timeout((thread_impl_t *) sched_p.sched_active_thread, wake_time);
+	sched_impl_wait_set(set, len, status);
+}
+
+void sched_impl_wake(thread_impl_t *client, unsigned int reason) {
+
+	/* disarm every record, whichever object fired has already been unlinked */
+	for (unsigned int i = 0; i < client->wait_set_len; ++i) {
+		wait_queue_remove_entry(&client->wait_set[i]);
+	}
+	client->wait_set_len = 0;
+
+	sched_impl_cancel_timeout(client);
+
+	client->wake_reason = reason;
+	sched_impl_unblock(client);
+}
+
+void sched_impl_wake_entry(wait_queue_entry_t *ent) {
+	ent->thr->wake_index = ent->index;
+	sched_impl_wake(ent->thr, WAKE_SIGNALLED);
+}
+
+thread_impl_t *sched_impl_wake_expired(unsigned int now) {
+	thread_impl_t *waker;
+
+	/* wake everything that is due, a stale compare from a cancelled timeout finds nothing to do */
+	while ((waker = sleep_queue_peek((sleep_queue_t *) &sched_p.sleep_mgr)) != NULL) {
+		if ((int) (now - waker->sq_entry.wake_time) < 0) break;
+
+		sleep_queue_pop((sleep_queue_t *) &sched_p.sleep_mgr);
+		waker->sleeping = false;
+		sched_impl_wake(waker, WAKE_TIMEOUT);
+	}
+
+	return waker;
+}
+
+/** @} */
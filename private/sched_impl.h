@@ -11,6 +11,7 @@
 #include "port_config.h"
 
 #include "sleep_queue.h"
+#include "wait_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +22,7 @@ extern "C" {
 #define DECLARE_SCHED_IMPL(type)											\
 	typedef type##_mgr_t sched_impl_mgr_t;									\
 	typedef type##_client_t sched_impl_client_t;							\
+	typedef type##_batch_t sched_impl_batch_t;								\
 
 /*-----------------------------------------------------------*/
 
@@ -41,6 +43,11 @@ extern "C" {
 #include SCHED_ALG_PATH
 DECLARE_SCHED_IMPL(vtrr);
 
+/* arch_sched_start() has to be running on the kernel stack while it hands the boot stack over */
+#if ((CONFIG_IDLE_USE_BOOT_STACK == 1) || (CONFIG_ISR_USE_BOOT_STACK == 1)) && (CONFIG_USE_KERNEL_STACK != 1)
+	#error "CONFIG_*_USE_BOOT_STACK requires CONFIG_USE_KERNEL_STACK"
+#endif
+
 typedef struct thread_impl thread_impl_t;
 typedef unsigned int sched_status_t;
 
@@ -70,8 +77,16 @@ typedef struct sched_impl {
 
 	void *boot_context;
 
-	#ifdef CONFIG_USE_KERNEL_STACK
-		uint8_t sched_isr_stack[CONFIG_ISR_STACK_SIZE];
+	uint32_t switches;					/* scheduler decisions that changed the running thread */
+	uint32_t switches_skipped;			/* decisions that kept it, returned from without a full save */
+
+	#if (CONFIG_USE_KERNEL_STACK == 1)
+		/* shared by the tick, yields and OS-aware ISRs, SP must stay word aligned */
+		#if (CONFIG_ISR_USE_BOOT_STACK == 1)
+			void *sched_isr_stack_top;		/* carved from the boot stack by arch_sched_start() */
+		#else
+			uint8_t sched_isr_stack[CONFIG_ISR_STACK_SIZE] __attribute__((aligned(sizeof(uintptr_t))));
+		#endif
 	#endif
 
 	#ifdef CONFIG_USE_TICK_HOOK
@@ -87,12 +102,87 @@ void sched_impl_add(thread_impl_t *client, unsigned int priority);
 void sched_impl_register(thread_impl_t *client);
 void sched_impl_deregister(thread_impl_t *client);
 void sched_impl_reregister(thread_impl_t *client, unsigned int priority);
+
+/**
+ * @name Bulk run queue construction.
+ * @brief Threads are staged with sched_impl_batch_add(), then installed together by sched_impl_add_batch().
+ * @details Staging in ascending priority order into an empty run queue builds it in linear time.
+ * @{
+ */
+void sched_impl_batch_init(sched_impl_batch_t *batch);
+void sched_impl_batch_add(sched_impl_batch_t *batch, thread_impl_t *client, unsigned int priority);
+void sched_impl_add_batch(sched_impl_batch_t *batch);
+/** @} */
 void sched_impl_start(void);
 void sched_impl_end(void);
+
+/**
+ * @brief Gives the idle thread its stack and builds its initial context.
+ * @details Called by sched_impl_init(), or by arch_sched_start() with a slice of the boot stack
+ * when CONFIG_IDLE_USE_BOOT_STACK is enabled.
+ */
+void sched_impl_idle_init(void *stack, size_t stack_size);
 void sched_impl_run(void);
 void sched_impl_yield(void);
 void sched_impl_yield_higher(void);
 
+/**
+ * @brief Makes a runnable thread the active one for the rest of the current slice, billed to the thread it was scheduled for.
+ */
+void sched_impl_switch_to(thread_impl_t *client);
+
+/**
+ * @brief Decides ahead of time which thread the next sched_impl_run() switches to. Must be called with interrupts locked.
+ */
+void sched_impl_plan(void);
+void sched_impl_sleep_until(unsigned int wake_time);
+
+/**
+ * @brief Takes the active thread off the run queue. The caller must yield afterwards to switch away.
+ * @param[in] status thread_status_t describing what the thread is blocked on.
+ */
+void sched_impl_block(unsigned int status);
+
+/**
+ * @brief Puts a blocked thread back on the run queue. Requests a context switch if called from an ISR.
+ */
+void sched_impl_unblock(thread_impl_t *client);
+
+/**
+ * @brief Links the active thread into several wait queues at once and takes it off the run queue.
+ * @details Each record must have 'que' and 'arg' filled in. The first object to fire wakes the thread
+ * and disarms the rest of the set. The caller must yield afterwards. The wake reason is left in the
+ * thread's wake_reason, and the record that fired in wake_index.
+ */
+void sched_impl_wait_set(wait_queue_entry_t *set, unsigned int len, unsigned int status);
+
+/**
+ * @brief Same as sched_impl_wait_set(), but also arms a timeout on the sleep queue.
+ */
+void sched_impl_wait_set_until(wait_queue_entry_t *set, unsigned int len, unsigned int status, unsigned int wake_time);
+
+/**
+ * @brief Wakes a blocked thread, unlinking it from whichever of its wait queues and sleep queue it is still on.
+ * @param[in] reason wake_reason_t reported to the woken thread.
+ */
+void sched_impl_wake(thread_impl_t *client, unsigned int reason);
+
+/**
+ * @brief Wakes the thread owning a wait record with WAKE_SIGNALLED, reporting the record's index.
+ */
+void sched_impl_wake_entry(wait_queue_entry_t *ent);
+
+/**
+ * @brief Disarms a pending timeout without waking the thread.
+ */
+void sched_impl_cancel_timeout(thread_impl_t *client);
+
+/**
+ * @brief Wakes every thread whose timeout has expired by 'now' with WAKE_TIMEOUT.
+ * @return The next thread due on the sleep queue, or NULL if it is empty.
+ */
+thread_impl_t *sched_impl_wake_expired(unsigned int now);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,12 +19,6 @@ static int sleepq_entry_cmp(const void *left, const void *right) {
 	return (long) a->wake_time - (long) b->wake_time;
 }
 
-static void sleepq_entry_copy(const void *src, void *dst) {
-	sleep_queue_entry_t *a = rb_entry_safe(src, sleep_queue_entry_t, node);
-	sleep_queue_entry_t *b = rb_entry_safe(dst, sleep_queue_entry_t, node);
-	b->wake_time = a->wake_time;
-}
-
 void sleep_queue_push(sleep_queue_t *que, thread_impl_t *thr, unsigned int wake_time) {
 	thr->sq_entry.wake_time = wake_time;
 	rb_lcached_insert(&que->q, &thr->sq_entry.node, sleepq_entry_cmp);
@@ -39,9 +33,9 @@ thread_impl_t *sleep_queue_peek(sleep_queue_t *que) {
 }
 
 void sleep_queue_pop(sleep_queue_t *que) {
-	rb_lcached_delete(&que->q, rb_first_cached(&que->q), sleepq_entry_cmp, sleepq_entry_copy);
+	rb_lcached_delete(&que->q, rb_first_cached(&que->q));
 }
 
 void sleep_queue_remove_node(sleep_queue_t *que, thread_impl_t *thr) {
-	rb_lcached_delete(&que->q, &thr->sq_entry.node, sleepq_entry_cmp, sleepq_entry_copy);
+	rb_lcached_delete(&que->q, &thr->sq_entry.node);
 }
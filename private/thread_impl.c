@@ -5,9 +5,118 @@
  *      Author: krad2
  */
 
+#include <string.h>
+
 #include "thread_impl.h"
+#include "irq.h"
 #include "hal.h"
+#include "sched.h"
+
+#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+
+#define THREAD_STACK_PAINT				0xa5
+#define THREAD_STACK_CANARY				((arch_reg_t) 0xc0de)
+
+static thread_impl_t *thread_impl_stacks = NULL;		/* every thread with a painted stack */
+static thread_impl_t *thread_impl_scan_cursor = NULL;	/* thread the idle thread is measuring */
+static const uint8_t *thread_impl_scan_pos = NULL;		/* where its scan resumes, NULL before it starts */
+
+void thread_impl_stack_init(thread_impl_t *me, void *stack, size_t stack_size) {
+	memset(stack, THREAD_STACK_PAINT, stack_size);
+	*(arch_reg_t *) stack = THREAD_STACK_CANARY;
+
+	me->stack_limit = (uint8_t *) stack;
+	me->stack_size = stack_size;
+	me->stack_high_water = 0;
+
+	irq_lock();
+
+	/* a TCB built again, like THREAD_DEFINE threads after a restart, must not be linked twice */
+	thread_impl_stack_release(me);
+
+	me->stack_next = thread_impl_stacks;
+	thread_impl_stacks = me;
+
+	irq_unlock();
+}
+
+void thread_impl_stack_release(thread_impl_t *me) {
+	irq_lock();
+
+	thread_impl_t **link = &thread_impl_stacks;
+	while (*link != NULL && *link != me) {
+		link = &(*link)->stack_next;
+	}
+
+	if (*link == me) *link = me->stack_next;
+	if (thread_impl_scan_cursor == me) {
+		thread_impl_scan_cursor = me->stack_next;
+		thread_impl_scan_pos = NULL;
+	}
+
+	irq_unlock();
+}
+
+void thread_impl_check_stack(thread_impl_t *me) {
+	if (me->stack_limit == NULL) return;
+
+	/* the context was just saved, so the stack pointer is at its lowest for this switch */
+	if ((uint8_t *) me->sp < me->stack_limit + sizeof(arch_reg_t) ||
+		*(arch_reg_t *) me->stack_limit != THREAD_STACK_CANARY) {
+		panic(PANIC_SSP, "Stack overflow");
+	}
+}
+
+void thread_impl_stack_scan_next(void) {
+	irq_lock();
+
+	thread_impl_t *me = thread_impl_scan_cursor;
+	if (me == NULL) me = thread_impl_stacks;
+
+	if (me != NULL) {
+		thread_impl_scan_cursor = me;
+
+		/* the scan stops at the first byte ever written, so it only costs as much as the headroom left */
+		const uint8_t *p = (thread_impl_scan_pos != NULL) ? thread_impl_scan_pos : me->stack_limit + sizeof(arch_reg_t);
+		const uint8_t *end = me->stack_limit + me->stack_size;
+
+		/* bounded, so interrupts are never held off for more than one chunk */
+		const uint8_t *stop = ((size_t) (end - p) > CONFIG_STACK_SCAN_CHUNK) ? p + CONFIG_STACK_SCAN_CHUNK : end;
+		while (p < stop && *p == THREAD_STACK_PAINT) {
+			p++;
+		}
+
+		if (p < stop) {
+
+			/* found the deepest write, move on to the next thread */
+			me->stack_high_water = (size_t) (end - p);
+			thread_impl_scan_cursor = me->stack_next;
+			thread_impl_scan_pos = NULL;
+		} else if (p == end) {
+
+			/* never touched beyond the canary */
+			me->stack_high_water = 0;
+			thread_impl_scan_cursor = me->stack_next;
+			thread_impl_scan_pos = NULL;
+		} else {
+			thread_impl_scan_pos = p;
+		}
+	}
+
+	irq_unlock();
+}
+
+#endif
+
+void thread_impl_init(thread_impl_t *me, void *stack, size_t stack_size, thread_fn_t runnable, void *args) {
+	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+		thread_impl_stack_init(me, stack, stack_size);
+	#endif
 
-void thread_impl_init(thread_impl_t *me, void *sp, thread_fn_t runnable, void *args) {
-	me->sp = (void *) arch_init_stack(sp, runnable, args);
+	me->sp = (void *) arch_init_stack((arch_reg_t *) ((uint8_t *) stack + stack_size), runnable, args);
+	me->frame = ARCH_FRAME_FULL;
+	me->status = STATUS_STOPPED;
+	me->sleeping = false;
+	me->wait_set = NULL;
+	me->wait_set_len = 0;
 }
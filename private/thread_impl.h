@@ -8,17 +8,80 @@
 #ifndef PRIVATE_THREAD_IMPL_H_
 #define PRIVATE_THREAD_IMPL_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include "sleep_queue.h"
+#include "wait_queue.h"
 #include "sched_impl.h"
 
 typedef struct thread_impl {
 	void *sp;
+	unsigned int frame;				/* ARCH_FRAME_* format of the context saved at sp */
 	sched_impl_client_t rq_entry;
 	sleep_queue_entry_t sq_entry;
+	wait_queue_entry_t wq_entry;
+	unsigned int status;			/* thread_status_t, anything below STATUS_RUNNING is off the run queue */
+	unsigned int wake_reason;		/* wake_reason_t reported by the last wait */
+	unsigned int wake_index;		/* wait record that satisfied the last wait */
+	bool sleeping;					/* sq_entry is linked into the sleep queue */
+
+	wait_queue_entry_t *wait_set;	/* wait records currently armed, wq_entry for single waits */
+	unsigned int wait_set_len;
+
+	#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+		uint8_t *stack_limit;			/* lowest address of the stack, holds the canary */
+		size_t stack_size;
+		size_t stack_high_water;		/* most bytes ever used, refreshed by the idle thread */
+		struct thread_impl *stack_next;	/* next thread on the idle thread's scan list */
+	#endif
 } thread_impl_t;
 
 typedef int (*thread_fn_t)(void *);
 
-void thread_impl_init(thread_impl_t *me, void *sp, thread_fn_t runnable, void *args);
+/**
+ * @brief Builds the initial context of a thread at the top of its stack.
+ * @param[in] stack Lowest address of the stack.
+ * @param[in] stack_size Size of the stack in bytes.
+ */
+void thread_impl_init(thread_impl_t *me, void *stack, size_t stack_size, thread_fn_t runnable, void *args);
+
+#if (CONFIG_CHECK_FOR_STACK_OVERFLOW == 1)
+
+/**
+ * @name Stack usage tracking.
+ * @details Stacks are painted with a known pattern under a canary word at their lowest address.
+ * The canary is checked whenever a thread is switched away from, and the idle thread measures the
+ * untouched paint of one thread per pass to keep each thread's high-water mark current.
+ * @{
+ */
+
+/**
+ * @brief Paints a stack, plants its canary and puts the thread on the scan list.
+ */
+void thread_impl_stack_init(thread_impl_t *me, void *stack, size_t stack_size);
+
+/**
+ * @brief Takes a thread off the scan list before its TCB and stack are released. Does nothing if it isn't on it.
+ */
+void thread_impl_stack_release(thread_impl_t *me);
+
+/**
+ * @brief Panics with PANIC_SSP if the thread's saved stack pointer or canary show an overflow.
+ */
+void thread_impl_check_stack(thread_impl_t *me);
+
+/**
+ * @brief Scans up to CONFIG_STACK_SCAN_CHUNK bytes of the next thread on the scan list. Called by the idle thread.
+ * @details A thread's high-water mark is refreshed once its scan reaches the deepest byte it ever wrote.
+ * Interrupts are let in between chunks, so a thread that runs in the meantime may go a little deeper
+ * than the mark shows until its next scan.
+ */
+void thread_impl_stack_scan_next(void);
+
+/** @} */
+
+#endif
 
 #endif /* PRIVATE_THREAD_IMPL_H_ */
@@ -0,0 +1,74 @@
+/*
+ * wait_queue.c
+ *
+ *  Created on: Jul 3, 2020
+ *      Author: krad2
+ */
+
+#include "rtos.h"
+#include "wait_queue.h"
+
+void wait_queue_init(wait_queue_t *que) {
+	que->head = NULL;
+	que->tail = NULL;
+}
+
+bool wait_queue_empty(wait_queue_t *que) {
+	return que->head == NULL;
+}
+
+void wait_queue_push(wait_queue_t *que, thread_impl_t *thr) {
+	wait_queue_entry_t *ent = &thr->wq_entry;
+
+	ent->thr = thr;
+	ent->index = 0;
+	wait_queue_push_entry(que, ent);
+}
+
+void wait_queue_push_entry(wait_queue_t *que, wait_queue_entry_t *ent) {
+
+	/* append to the tail so waiters are woken in arrival order */
+	ent->next = NULL;
+	ent->prev = que->tail;
+	ent->que = que;
+
+	if (que->tail != NULL) que->tail->next = ent;
+	else que->head = ent;
+
+	que->tail = ent;
+}
+
+thread_impl_t *wait_queue_peek(wait_queue_t *que) {
+	if (que->head == NULL) return NULL;
+	return que->head->thr;
+}
+
+wait_queue_entry_t *wait_queue_peek_entry(wait_queue_t *que) {
+	return que->head;
+}
+
+void wait_queue_pop(wait_queue_t *que) {
+	if (que->head == NULL) return;
+	wait_queue_remove_entry(que->head);
+}
+
+void wait_queue_remove_node(wait_queue_t *que, thread_impl_t *thr) {
+	if (thr->wq_entry.que != que) return;
+	wait_queue_remove_entry(&thr->wq_entry);
+}
+
+void wait_queue_remove_entry(wait_queue_entry_t *ent) {
+	wait_queue_t *que = ent->que;
+	if (que == NULL) return;
+
+	/* unlink in constant time, fixing up the ends of the queue if necessary */
+	if (ent->prev != NULL) ent->prev->next = ent->next;
+	else que->head = ent->next;
+
+	if (ent->next != NULL) ent->next->prev = ent->prev;
+	else que->tail = ent->prev;
+
+	ent->next = NULL;
+	ent->prev = NULL;
+	ent->que = NULL;
+}
@@ -0,0 +1,54 @@
+/*
+ * wait_queue.h
+ *
+ *  Created on: Jul 3, 2020
+ *      Author: krad2
+ */
+
+#ifndef PRIVATE_WAIT_QUEUE_H_
+#define PRIVATE_WAIT_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct thread_impl thread_impl_t;
+
+/**
+ * @brief Wait record linking a blocked thread into one kernel object's wait queue. Waiters are served in FIFO order.
+ * @details A thread owns one record per object it waits on. Single waits use the record embedded in the
+ * thread, multi-object waits use an array of records on the waiting thread's stack.
+ */
+typedef struct wait_queue_entry {
+	struct wait_queue_entry *next;
+	struct wait_queue_entry *prev;
+	struct wait_queue *que;		/* queue the entry is linked into, NULL when unlinked */
+	thread_impl_t *thr;			/* the waiting thread */
+	unsigned int index;			/* position of the record in the thread's wait set */
+	uintptr_t arg;				/* object-specific request and result, e.g. a message destination or flag mask */
+} wait_queue_entry_t;
+
+typedef struct wait_queue {
+	wait_queue_entry_t *head;	/* oldest waiter, first to be woken */
+	wait_queue_entry_t *tail;	/* newest waiter */
+} wait_queue_t;
+
+void wait_queue_init(wait_queue_t *que);
+
+bool wait_queue_empty(wait_queue_t *que);
+
+void wait_queue_push(wait_queue_t *que, thread_impl_t *thr);
+
+void wait_queue_push_entry(wait_queue_t *que, wait_queue_entry_t *ent);
+
+thread_impl_t *wait_queue_peek(wait_queue_t *que);
+
+wait_queue_entry_t *wait_queue_peek_entry(wait_queue_t *que);
+
+void wait_queue_pop(wait_queue_t *que);
+
+void wait_queue_remove_node(wait_queue_t *que, thread_impl_t *thr);
+
+void wait_queue_remove_entry(wait_queue_entry_t *ent);
+
+#endif /* PRIVATE_WAIT_QUEUE_H_ */
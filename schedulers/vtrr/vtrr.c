@@ -41,7 +41,7 @@ static void vtrr_client_init(vtrr_client_t *client, unsigned int priority) {
 	client->fin_time = 0;
 	client->timestep = VTRR_TIMESTEP(client->shares);	/* precalculate the progress rate because division is slow */
 
-	rbnode_init(&client->rq_entry);
+	rbtnode_init(&client->rq_entry);
 }
 
 static void vtrr_client_update(vtrr_client_t *client, unsigned int priority) {
@@ -86,18 +86,6 @@ static int vtrr_client_cmp(const void *left, const void *right) {
     return a->shares - b->shares;
 }
 
-/**
- * @brief Copy node callback between 2 clients.
- */
-static void vtrr_client_copy(const void *src, void *dst) {
-    vtrr_client_t *a = vtrr_entry(src);
-    vtrr_client_t *b = vtrr_entry(dst);
-
-    b->shares = a->shares;
-    b->runs_left = a->runs_left;
-    b->fin_time = a->fin_time;
-}
-
 /**
  * @brief Foreach callback. Invoked at the end of every scheduling cycle.
  */
@@ -116,9 +104,9 @@ static void vtrr_client_reset(void *key) {
  */
 
 /**
- * @brief Adds a thread to the run queue.
+ * @brief Charges an arriving thread to the current cycle. The group timestep is left to the caller.
  */
-static void vtrr_client_add_to_list(vtrr_mgr_t *mgr, vtrr_client_t *client) {
+static void vtrr_client_arrive(vtrr_mgr_t *mgr, vtrr_client_t *client) {
 
 	/* the arrival time of the task is the proportion of time in a cycle */
 	client->fin_time = max(client->fin_time, mgr->group_time + client->timestep);
@@ -129,10 +117,21 @@ static void vtrr_client_add_to_list(vtrr_mgr_t *mgr, vtrr_client_t *client) {
 
 	mgr->shares += client->shares;
 	mgr->runs_left += client->runs_left;		/* lengthen the scheduling cycle */
+}
+
+/**
+ * @brief Adds a thread to the run queue.
+ */
+static void vtrr_client_add_to_list(vtrr_mgr_t *mgr, vtrr_client_t *client) {
+	vtrr_client_arrive(mgr, client);
 	mgr->timestep = VTRR_TIMESTEP(mgr->shares);	/* recalculate the group timestep */
 
-	rb_rcached_insert(&mgr->rq, &client->rq_entry, vtrr_client_cmp);
+	rb_threaded_insert(&mgr->rq, &client->rq_entry.node, vtrr_client_cmp);
 	mgr->curr_max = rb_last_cached(&mgr->rq);	/* update the max whenever something is added or deleted */
+
+	/* a queue that was drained by blocking threads has nothing planned, so plan the new arrival */
+	if (mgr->next_cli == NULL) mgr->next_cli = mgr->curr_max;
+	mgr->planned = false;
 }
 
 /**
@@ -143,8 +142,109 @@ static void vtrr_client_remove_from_list(vtrr_mgr_t *mgr, vtrr_client_t *client)
 	mgr->runs_left -= client->runs_left;		/* shorten the scheduling cycle */
 	mgr->timestep = VTRR_TIMESTEP(mgr->shares);	/* recalculate the group timestep */
 
-	rb_rcached_delete(&mgr->rq, &client->rq_entry, vtrr_client_cmp, vtrr_client_copy);
+	rb_threaded_delete(&mgr->rq, &client->rq_entry.node);
 	mgr->curr_max = rb_last_cached(&mgr->rq);	/* update the max whenever something is added or deleted */
+
+	/* a blocking thread must never be handed the next slice, or be charged for the current one */
+	if (mgr->next_cli == &client->rq_entry.node) mgr->next_cli = mgr->curr_max;
+	if (mgr->curr_cli == &client->rq_entry.node) mgr->curr_cli = NULL;
+	if (mgr->donor == &client->rq_entry.node) mgr->donor = NULL;
+	if (mgr->prev_cli == &client->rq_entry.node) mgr->prev_cli = NULL;
+	mgr->planned = false;
+}
+
+/**
+ * @brief Builds an empty run queue from clients chained in ascending priority order.
+ */
+static void vtrr_client_build_list(vtrr_mgr_t *mgr, rbnode *head, unsigned int len) {
+
+	/* a fresh cycle hands every client its full share, so the totals are plain sums */
+	for (rbnode *node = head; node != NULL; node = node->right) {
+		vtrr_client_t *client = vtrr_entry(node);
+
+		client->fin_time = max(client->fin_time, mgr->group_time + client->timestep);
+		client->runs_left = client->shares;
+
+		mgr->shares += client->shares;
+		mgr->runs_left += client->runs_left;
+	}
+
+	mgr->timestep = VTRR_TIMESTEP(mgr->shares);
+
+	rb_threaded_build(&mgr->rq, head, len);
+	mgr->curr_max = rb_last_cached(&mgr->rq);
+
+	if (mgr->next_cli == NULL) mgr->next_cli = mgr->curr_max;
+	mgr->planned = false;
+}
+
+/**
+ * @brief Merges two client chains in ascending priority order, linked through their right pointers.
+ * @details Ties go to the first chain, as rb_threaded_insert() places an equal key after the ones already there.
+ */
+static rbnode *vtrr_client_merge(rbnode *first, rbnode *second) {
+	rbnode head;
+	rbnode *tail = &head;
+
+	while (first != NULL && second != NULL) {
+		if (vtrr_client_cmp(second, first) < 0) {
+			tail->right = second;
+			second = second->right;
+		} else {
+			tail->right = first;
+			first = first->right;
+		}
+
+		tail = tail->right;
+	}
+
+	tail->right = (first != NULL) ? first : second;
+	return head.right;
+}
+
+/**
+ * @brief Stable merge sort of the first n clients of a chain linked through their right pointers.
+ * @details Advances *list past the sorted clients. Recurses log2(n) deep.
+ */
+static rbnode *vtrr_client_sort(rbnode **list, unsigned int n) {
+	if (n == 1) {
+		rbnode *node = *list;
+		*list = node->right;
+		node->right = NULL;
+		return node;
+	}
+
+	rbnode *first = vtrr_client_sort(list, n / 2);
+	rbnode *second = vtrr_client_sort(list, n - (n / 2));
+	return vtrr_client_merge(first, second);
+}
+
+/**
+ * @brief Merges clients chained in ascending priority order into a non-empty run queue and rebuilds it in linear time.
+ * @details Arrivals are charged as if added one at a time. The existing clients keep their nodes, so every
+ * cursor into the run queue stays valid.
+ */
+static void vtrr_client_merge_list(vtrr_mgr_t *mgr, rbnode *head) {
+	unsigned int n = 0;
+
+	for (rbnode *node = head; node != NULL; node = node->right) {
+		vtrr_client_arrive(mgr, vtrr_entry(node));
+		n++;
+	}
+
+	mgr->timestep = VTRR_TIMESTEP(mgr->shares);
+
+	/* chain the run queue through the right pointers, the thread is untouched until the rebuild */
+	for (rbnode *node = rb_first_cached(&mgr->rq); node != NULL; node = rb_threaded_next(node)) {
+		node->right = rb_threaded_next(node);
+		n++;
+	}
+
+	rb_threaded_build(&mgr->rq, vtrr_client_merge(rb_first_cached(&mgr->rq), head), n);
+	mgr->curr_max = rb_last_cached(&mgr->rq);
+
+	if (mgr->next_cli == NULL) mgr->next_cli = mgr->curr_max;
+	mgr->planned = false;
 }
 
 /** @} */
@@ -160,11 +260,14 @@ static void vtrr_client_remove_from_list(vtrr_mgr_t *mgr, vtrr_client_t *client)
  * @brief Sets up a scheduling instance.
  */
 static void vtrr_mgr_init(vtrr_mgr_t *mgr) {
-	rbtree_rcached_init(&mgr->rq);
+	rbtree_threaded_init(&mgr->rq);
 
 	mgr->curr_cli = NULL;
 	mgr->next_cli = NULL;
 	mgr->curr_max = NULL;
+	mgr->donor = NULL;
+	mgr->prev_cli = NULL;
+	mgr->planned = false;
 
 	mgr->shares = 0;
 	mgr->runs_left = 0;
@@ -179,6 +282,8 @@ static void vtrr_mgr_start(vtrr_mgr_t *mgr) {
 	mgr->curr_max = rb_last_cached(&mgr->rq);
 	mgr->curr_cli = mgr->curr_max;
 	mgr->next_cli = mgr->curr_max;
+	mgr->prev_cli = NULL;
+	mgr->planned = true;						/* the first slice goes to the highest priority thread */
 	mgr->timestep = VTRR_TIMESTEP(mgr->shares);	/* calculate the initial group timestep from the installed tasks */
 }
 
@@ -189,9 +294,12 @@ static void vtrr_mgr_end(vtrr_mgr_t *mgr) {
 	mgr->curr_cli = NULL;
 	mgr->next_cli = NULL;
 	mgr->curr_max = NULL;
+	mgr->donor = NULL;
+	mgr->prev_cli = NULL;
+	mgr->planned = false;
 	mgr->timestep = 0;
 
-	rb_rcached_clean(&mgr->rq);					/* empties the run queue */
+	rb_threaded_clean(&mgr->rq);				/* empties the run queue */
 }
 
 /**
@@ -199,24 +307,25 @@ static void vtrr_mgr_end(vtrr_mgr_t *mgr) {
  * @param[in] cb Function to apply per task.
  */
 static void vtrr_mgr_task_foreach(vtrr_mgr_t *mgr, void (*cb)(void *)) {
-	rb_inorder_foreach(&mgr->rq.tree, cb);
+	rb_threaded_foreach(&mgr->rq, cb);
 }
 
 /**
- * @brief Scheduling algorithm invoked by yield() and the timeslicer.
+ * @brief Decides which thread follows the running one. Does nothing if the decision is still current.
+ * @details Separate from vtrr_mgr_commit() so it can run ahead of time, outside the timeslicer.
  */
-static void vtrr_mgr_run(vtrr_mgr_t *mgr) {
+static void vtrr_mgr_plan(vtrr_mgr_t *mgr) {
+	if (mgr->planned) return;
+	mgr->planned = true;
 
-	/* execution of the scheduled thread */
-	vtrr_client_t *curr_client = vtrr_active_client(mgr);
-	vtrr_client_run(curr_client);
+	/* a handoff doesn't move the cycle, so the walk goes on from the thread the slice was scheduled for */
+	rbnode *slice_cli = (mgr->donor != NULL) ? mgr->donor : mgr->curr_cli;
 
-	/* assign the thread previously planned for execution */
-	mgr->curr_cli = mgr->next_cli;
-	mgr->group_time += mgr->timestep;
-	if (mgr->runs_left > 0) mgr->runs_left--;
+	/* with an empty run queue, or a running thread that blocked, next_cli was already repaired on removal */
+	if (mgr->curr_max == NULL || slice_cli == NULL) return;
 
-	if (mgr->curr_cli == NULL) panic(0, "current client is null");
+	/* the thread that was billed for the last slice, or the scheduled one if it has since left the run queue */
+	vtrr_client_t *curr_client = vtrr_entry((mgr->prev_cli != NULL) ? mgr->prev_cli : slice_cli);
 
 	/* if a cycle has completed */
 	if (mgr->runs_left == 0) {
@@ -237,12 +346,12 @@ static void vtrr_mgr_run(vtrr_mgr_t *mgr) {
 	} else if (!vtrr_client_is_runnable(vtrr_entry(mgr->curr_max))) {
 
 		/* the 2nd highest priority thread becomes the highest so far */
-		mgr->curr_max = (rbnode *) rb_prev(mgr->curr_max);
+		mgr->curr_max = rb_threaded_prev(mgr->curr_max);
 		if (mgr->curr_max == NULL) panic(0, "curr max is null");
 	}
 
 	/* assume that the next thread to be scheduled will be the next thread in sorted order */
-	rbnode *next_node = (rbnode *) rb_prev(mgr->curr_cli);
+	rbnode *next_node = rb_threaded_prev(slice_cli);
 
 	/* if it doesn't exist, just go back to the top */
 	if (next_node == NULL) {
@@ -269,6 +378,39 @@ static void vtrr_mgr_run(vtrr_mgr_t *mgr) {
 	}
 }
 
+/**
+ * @brief Bills the slice that just ended and switches to the planned thread. Constant time.
+ */
+static void vtrr_mgr_commit(vtrr_mgr_t *mgr) {
+
+	/* execution of the scheduled thread, unless it left the run queue during its slice */
+	rbnode *billed = (mgr->donor != NULL) ? mgr->donor : mgr->curr_cli;
+	mgr->donor = NULL;
+
+	/* a handed-off slice is billed to its donor, which also keeps its place in the cycle */
+	if (billed != NULL) vtrr_client_run(vtrr_entry(billed));
+	mgr->prev_cli = (billed != NULL) ? billed : mgr->next_cli;
+
+	/* assign the thread previously planned for execution */
+	mgr->curr_cli = mgr->next_cli;
+	mgr->group_time += mgr->timestep;
+	if (mgr->runs_left > 0) mgr->runs_left--;
+
+	if (mgr->curr_cli == NULL) panic(0, "current client is null");
+
+	/* the plan was for the slice that just started, the one after it is still undecided */
+	mgr->planned = false;
+}
+
+/**
+ * @brief Scheduling algorithm invoked by yield() and the timeslicer. Constant time.
+ * @details Commits next_cli even if the plan is stale. Run queue changes keep it pointing at a runnable
+ * thread, and the next vtrr_plan() picks up from wherever this leaves the cycle.
+ */
+static void vtrr_mgr_run(vtrr_mgr_t *mgr) {
+	vtrr_mgr_commit(mgr);
+}
+
 /**
  * @brief Surrenders timeslice by scheduling the next thread in order.
  */
@@ -286,10 +428,21 @@ static void vtrr_mgr_yield_higher(vtrr_mgr_t *mgr) {
 
 		/* switch it and run it if that's true */
 		mgr->next_cli = mgr->curr_max;
+		mgr->planned = true;
 		vtrr_mgr_run(mgr);
 	}
 }
 
+/**
+ * @brief Runs another client for the rest of the slice without charging it.
+ */
+static void vtrr_mgr_switch_to(vtrr_mgr_t *mgr, vtrr_client_t *client) {
+
+	/* the client the slice was scheduled for pays for it, however many times it's handed on */
+	if (mgr->donor == NULL) mgr->donor = mgr->curr_cli;
+	mgr->curr_cli = &client->rq_entry.node;
+}
+
 /** @} */
 
 /*-----------------------------------------------------------*/
@@ -307,6 +460,40 @@ void vtrr_add(vtrr_mgr_t *sched, vtrr_client_t *client, unsigned int priority) {
 	vtrr_client_add_to_list(sched, client);
 }
 
+void vtrr_batch_init(vtrr_batch_t *batch) {
+	batch->head = NULL;
+	batch->tail = NULL;
+	batch->len = 0;
+	batch->sorted = true;
+}
+
+void vtrr_batch_add(vtrr_batch_t *batch, vtrr_client_t *client, unsigned int priority) {
+	vtrr_client_init(client, priority);
+
+	if (batch->tail == NULL) {
+		batch->head = &client->rq_entry.node;
+	} else {
+		if (vtrr_entry(batch->tail)->shares > priority) batch->sorted = false;
+		batch->tail->right = &client->rq_entry.node;
+	}
+
+	batch->tail = &client->rq_entry.node;
+	batch->len++;
+}
+
+void vtrr_add_batch(vtrr_mgr_t *sched, vtrr_batch_t *batch) {
+	if (batch->len == 0) return;
+
+	rbnode *head = batch->head;
+	if (!batch->sorted) {
+		rbnode *list = batch->head;
+		head = vtrr_client_sort(&list, batch->len);
+	}
+
+	if (RB_NULL_ROOT(&sched->rq.tree)) vtrr_client_build_list(sched, head, batch->len);
+	else vtrr_client_merge_list(sched, head);
+}
+
 void vtrr_register(vtrr_mgr_t *sched, vtrr_client_t *client) {
 	vtrr_client_add_to_list(sched, client);
 }
@@ -337,3 +524,11 @@ void vtrr_yield(vtrr_mgr_t *sched) {
 void vtrr_yield_higher(vtrr_mgr_t *sched) {
 	vtrr_mgr_yield_higher(sched);
 }
+
+void vtrr_switch_to(vtrr_mgr_t *sched, vtrr_client_t *client) {
+	vtrr_mgr_switch_to(sched, client);
+}
+
+void vtrr_plan(vtrr_mgr_t *sched) {
+	vtrr_mgr_plan(sched);
+}
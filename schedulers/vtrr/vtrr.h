@@ -32,7 +32,7 @@ typedef struct sched_vtrr_client {
 	unsigned int fin_time;		/* virtual timestamp for VTRR allocation computations */
 	unsigned int timestep;		/* virtual progress amount for each timestep */
 
-	rbnode rq_entry;			/* red-black tree entry for sorted order */
+	rbtnode rq_entry;			/* red-black tree entry, threaded so the walk down the run queue is O(1) per step */
 } vtrr_client_t;
 
 typedef struct sched_vtrr_mgr {
@@ -41,13 +41,23 @@ typedef struct sched_vtrr_mgr {
 	unsigned int group_time;	/* virtual timestamp for thread progress comparisons */
 	unsigned int timestep;		/* virtual progress amount for each timestep */
 
-	rbtree_rcached rq;			/* red-black tree for sorted threads, maximum is cached */
+	rbtree_threaded rq;			/* red-black tree for sorted threads, maximum is cached */
 	rbnode *curr_max;			/* pointer to the highest priority runnable thread */
 
 	rbnode *curr_cli;			/* pointer to the currently running thread */
 	rbnode *next_cli;			/* pointer to the thread scheduled for the next timeslice */
+	rbnode *donor;				/* thread billed for the current timeslice after a handoff, NULL if none */
+	rbnode *prev_cli;			/* thread billed for the last timeslice, consulted when planning */
+	bool planned;				/* next_cli is up to date with the run queue */
 } vtrr_mgr_t;
 
+typedef struct sched_vtrr_batch {
+	rbnode *head;				/* staged clients, chained in order through their rq_entry right pointers */
+	rbnode *tail;
+	unsigned int len;
+	bool sorted;				/* staged in ascending priority order */
+} vtrr_batch_t;
+
 /** @} */
 
 /*-----------------------------------------------------------*/
@@ -57,10 +67,11 @@ typedef struct sched_vtrr_mgr {
  * @{
  */
 
-#define __vtrr_entry(ptr) rb_entry((ptr), vtrr_client_t, rq_entry)
+#define __vtrr_entry(ptr) rb_entry((ptr), vtrr_client_t, rq_entry.node)
 #define vtrr_entry(ptr) __vtrr_entry((ptr))
 #define vtrr_active_client(mptr) __vtrr_entry((mptr)->curr_cli)
 #define vtrr_next_client(mptr) __vtrr_entry((mptr)->next_cli)
+#define vtrr_planned(mptr) ((mptr)->planned)
 
 /** @} */
 
@@ -109,6 +120,25 @@ void vtrr_deregister(vtrr_mgr_t *sched, vtrr_client_t *client);
  */
 void vtrr_reregister(vtrr_mgr_t *sched, vtrr_client_t *client, unsigned int priority);
 
+/**
+ * @brief Prepares an empty staging list for vtrr_add_batch().
+ */
+void vtrr_batch_init(vtrr_batch_t *batch);
+
+/**
+ * @brief Initializes a new thread and stages it for vtrr_add_batch().
+ * @param[in] priority Thread scheduling priority.
+ */
+void vtrr_batch_add(vtrr_batch_t *batch, vtrr_client_t *client, unsigned int priority);
+
+/**
+ * @brief Adds every staged thread to the run queue.
+ * @details Threads staged out of priority order are merge sorted first. An empty run queue is then built
+ * balanced in linear time, with the cycle totals summed in the same pass. A non-empty one is merged with
+ * the batch and rebuilt in linear time, charging the threads as vtrr_add() would one at a time.
+ */
+void vtrr_add_batch(vtrr_mgr_t *sched, vtrr_batch_t *batch);
+
 /**
  * @brief Readies the VTRR manager for timeslicing.
  * @details At least 1 thread must be installed for the manager to start.
@@ -135,6 +165,22 @@ void vtrr_yield(vtrr_mgr_t *sched);
  */
 void vtrr_yield_higher(vtrr_mgr_t *sched);
 
+/**
+ * @brief Hands the rest of the current timeslice to another runnable thread.
+ * @details The slice is billed to the thread it was scheduled for, which also keeps its place in the cycle,
+ * so the recipient's allowance and virtual time are untouched. Chained handoffs keep billing the first donor.
+ * @param[in] client Thread to run next, already on the run queue.
+ */
+void vtrr_switch_to(vtrr_mgr_t *sched, vtrr_client_t *client);
+
+/**
+ * @brief Decides ahead of time which thread vtrr_run() will switch to next, if that isn't decided already.
+ * @details vtrr_run() only bills the slice and swaps in next_cli, in constant time, so it has to be called
+ * after every vtrr_run() and every change to the run queue, which throws the plan away. A stale plan
+ * still names a runnable thread, just not necessarily the one VTRR order would pick.
+ */
+void vtrr_plan(vtrr_mgr_t *sched);
+
 /** @} */
 
 #ifdef __cplusplus